@@ -17,6 +17,13 @@ else()
   print_status("JCDP OpenMP support: OFF")
 endif()
 
+# Instrumentation
+if(JCDP_INSTRUMENTATION)
+  print_status("JCDP instrumentation: ON")
+else()
+  print_status("JCDP instrumentation: OFF")
+endif()
+
 # Doxygen
 if(JCDP_BUILD_DOXYGEN)
   print_status("JCDP build doxygen: ON")
@@ -8,7 +8,9 @@ corresponding
 
 from __future__ import annotations
 
+import struct
 import sys
+import numpy as np
 import pandas as pd
 import matplotlib.pyplot as plt
 import seaborn as sns
@@ -29,15 +31,53 @@ Example uses:
 
   generate_plots.py results3.csv foo.pgf
     Creates pgfplots to be included in LaTeX.
+
+  generate_plots.py results3.jcdprec
+    Reads the binary records (batch_output binary) instead of the CSV.
 """
 
+RECORD_MAGIC = b"JCDPREC\0"
+RECORD_VERSION = 1
+RECORD_TYPES = {0: "<u8", 1: "<f8", 2: "?"}
+
+
+# -------------------------------------------------------------------- #
+def read_records(input_file: str) -> pd.DataFrame:
+    """Read a binary record file (see jcdp/util/record_writer.hpp)."""
+
+    with open(input_file, "rb") as f:
+        data = f.read()
+
+    if data[:8] != RECORD_MAGIC:
+        raise ValueError(f"{input_file} is not a JCDP record file")
+    version, columns, record_size = struct.unpack_from("<IIQ", data, 8)
+    if version != RECORD_VERSION:
+        raise ValueError(f"Unsupported record version {version}")
+
+    offset = 24
+    fields = []
+    for _ in range(columns):
+        kind, length = struct.unpack_from("<BI", data, offset)
+        offset += 5
+        name = data[offset : offset + length].decode()
+        offset += length
+        fields.append((name, RECORD_TYPES[kind]))
+
+    dtype = np.dtype(fields)
+    assert dtype.itemsize == record_size
+    records = np.frombuffer(data, dtype=dtype, offset=offset)
+    return pd.DataFrame(records)
+
 
 # -------------------------------------------------------------------- #
 def main(input_file: str, output_file: str | None) -> int:
     """Run the plot generator."""
 
     # Read the data into a DataFrame
-    df = pd.read_csv(input_file)
+    if input_file.endswith(".jcdprec"):
+        df = read_records(input_file)
+    else:
+        df = pd.read_csv(input_file)
 
     # Determine the number of machines
     m = max(int(col.split("/")[1]) for col in df.columns if "BnB_BnB" in col)
@@ -134,7 +174,7 @@ if __name__ == "__main__":
     parser.add_argument(
         "input_file",
         type=str,
-        help="Path to the CSV file.",
+        help="Path to the CSV (or binary record) file.",
     )
     parser.add_argument(
         "output_file",
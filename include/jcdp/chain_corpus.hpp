@@ -0,0 +1,279 @@
+/******************************************************************************
+ * @file jcdp/chain_corpus.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides a binary file
+ *        format for a corpus of Jacobian chains, e.g. generated ones or ones
+ *        harvested from real tapes, and a memory-mapped reader for it.
+ ******************************************************************************/
+
+#ifndef JCDP_CHAIN_CORPUS_HPP_
+#define JCDP_CHAIN_CORPUS_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "jcdp/chain_source.hpp"
+#include "jcdp/jacobian.hpp"
+#include "jcdp/jacobian_chain.hpp"
+#include "jcdp/util/mapped_file.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp {
+
+//! Converts between the little endian integers of a corpus and the byte
+//! order of the host (both ways).
+template<typename T>
+inline constexpr auto corpus_order(const T value) -> T {
+   if constexpr (std::endian::native == std::endian::big) {
+      return std::byteswap(value);
+   }
+   return value;
+}
+
+/******************************************************************************
+ * @brief Fields of an elemental Jacobian as stored in a corpus, i.e. little
+ *        endian (see corpus_order).
+ ******************************************************************************/
+struct CorpusJacobian {
+   std::uint64_t n {0};
+   std::uint64_t m {0};
+   std::uint64_t ku {0};
+   std::uint64_t kl {0};
+   std::uint64_t non_zero_elements {0};
+   std::uint64_t edges_in_dag {0};
+   std::uint64_t tangent_cost {0};
+   std::uint64_t adjoint_cost {0};
+};
+
+static_assert(sizeof(CorpusJacobian) == 64);
+
+/******************************************************************************
+ * @brief Layout of a corpus file (all integers are little endian u64 unless
+ *        noted otherwise):
+ *
+ *   char[8]  magic "JCDPCHN\0"
+ *   u32      version
+ *   u32      size of a Jacobian record (64)
+ *   u64      amount of chains c
+ *   u64      offset of the index in bytes
+ *   Jacobian records of all chains, back to back (see CorpusJacobian)
+ *   index: c + 1 record numbers, the first record of every chain followed
+ *          by the total amount of records
+ ******************************************************************************/
+struct CorpusHeader {
+   char magic[8] {'J', 'C', 'D', 'P', 'C', 'H', 'N', '\0'};
+   std::uint32_t version {1};
+   std::uint32_t record_size {sizeof(CorpusJacobian)};
+   std::uint64_t chains {0};
+   std::uint64_t index_offset {0};
+};
+
+static_assert(sizeof(CorpusHeader) == 32);
+
+//! Header with all integers converted, see corpus_order.
+inline auto corpus_order(CorpusHeader header) -> CorpusHeader {
+   header.version = corpus_order(header.version);
+   header.record_size = corpus_order(header.record_size);
+   header.chains = corpus_order(header.chains);
+   header.index_offset = corpus_order(header.index_offset);
+   return header;
+}
+
+/******************************************************************************
+ * @brief Writes chains to a new corpus file.
+ *
+ * The records are streamed, only the index is kept until finish(), which
+ * has to be called to complete the file.
+ ******************************************************************************/
+class ChainCorpusWriter {
+ public:
+   explicit ChainCorpusWriter(const std::filesystem::path& path)
+      : m_out(path, std::ios::binary) {
+      if (!m_out) {
+         throw std::runtime_error("Failed to open " + path.string());
+      }
+      const CorpusHeader header = corpus_order(CorpusHeader {});
+      write(&header, sizeof(header));
+      m_index.push_back(0);
+   }
+
+   inline auto add(const JacobianChain& chain) -> void {
+      for (const Jacobian& jac : chain.elemental_jacobians) {
+         const CorpusJacobian record {
+              .n = corpus_order<std::uint64_t>(jac.n),
+              .m = corpus_order<std::uint64_t>(jac.m),
+              .ku = corpus_order<std::uint64_t>(jac.ku),
+              .kl = corpus_order<std::uint64_t>(jac.kl),
+              .non_zero_elements = corpus_order<std::uint64_t>(
+                   jac.non_zero_elements),
+              .edges_in_dag = corpus_order<std::uint64_t>(jac.edges_in_dag),
+              .tangent_cost = corpus_order<std::uint64_t>(jac.tangent_cost),
+              .adjoint_cost = corpus_order<std::uint64_t>(jac.adjoint_cost)};
+         write(&record, sizeof(record));
+      }
+      m_index.push_back(m_index.back() + chain.length());
+   }
+
+   //! Write the index and the final header. Throws if the file is broken.
+   inline auto finish() -> void {
+      CorpusHeader header {};
+      header.chains = m_index.size() - 1;
+      header.index_offset = sizeof(CorpusHeader) +
+                            m_index.back() * sizeof(CorpusJacobian);
+      header = corpus_order(header);
+      for (std::uint64_t& first : m_index) {
+         first = corpus_order(first);
+      }
+      write(m_index.data(), m_index.size() * sizeof(std::uint64_t));
+
+      m_out.seekp(0);
+      write(&header, sizeof(header));
+      m_out.close();
+      if (!m_out) {
+         throw std::runtime_error("Failed to write the chain corpus");
+      }
+   }
+
+ private:
+   std::ofstream m_out;
+   std::vector<std::uint64_t> m_index {};
+
+   inline auto write(const void* data, const std::size_t size) -> void {
+      m_out.write(static_cast<const char*>(data), size);
+   }
+};
+
+/******************************************************************************
+ * @brief Read-only view of a corpus file.
+ *
+ * The file is memory-mapped, so opening does not depend on the amount of
+ * chains and the records are read in place. Only load() copies the records
+ * of a single chain, converted to the byte order of the host.
+ ******************************************************************************/
+class ChainCorpus : public ChainSource {
+ public:
+   ChainCorpus() = default;
+
+   //! Throws a std::runtime_error if the file is no valid corpus.
+   explicit ChainCorpus(const std::filesystem::path& path) : m_file(path) {
+      const std::span<const std::byte> bytes = m_file.bytes();
+      CorpusHeader header {};
+      if (bytes.size() < sizeof(header)) {
+         throw std::runtime_error(path.string() + " is no chain corpus");
+      }
+      std::memcpy(&header, bytes.data(), sizeof(header));
+      header = corpus_order(header);
+
+      const CorpusHeader expected {};
+      if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) ||
+          header.version != expected.version ||
+          header.record_size != expected.record_size) {
+         throw std::runtime_error(
+              path.string() + " is no chain corpus (version 1)");
+      }
+
+      // Index and records have to be within the file and consistent
+      const std::uint64_t records_size = header.index_offset -
+                                         sizeof(CorpusHeader);
+      if (header.index_offset < sizeof(CorpusHeader) ||
+          records_size % sizeof(CorpusJacobian) != 0 ||
+          header.index_offset > bytes.size() ||
+          (bytes.size() - header.index_offset) / sizeof(std::uint64_t) <=
+               header.chains) {
+         throw std::runtime_error("Truncated chain corpus " + path.string());
+      }
+      m_index = {
+           reinterpret_cast<const std::uint64_t*>(
+                bytes.data() + header.index_offset),
+           header.chains + 1};
+      m_records = {
+           reinterpret_cast<const CorpusJacobian*>(
+                bytes.data() + sizeof(CorpusHeader)),
+           records_size / sizeof(CorpusJacobian)};
+
+      // Every chain has at least one Jacobian
+      for (std::size_t c = 0; c < size(); ++c) {
+         if (first(c) >= first(c + 1)) {
+            throw std::runtime_error("Corrupt chain corpus " + path.string());
+         }
+      }
+      if (first(0) != 0 || first(size()) != m_records.size()) {
+         throw std::runtime_error("Corrupt chain corpus " + path.string());
+      }
+   }
+
+   //! Amount of chains.
+   inline auto size() const -> std::size_t override {
+      return m_index.empty() ? 0 : m_index.size() - 1;
+   }
+
+   inline auto length(const std::size_t chain) const
+        -> std::size_t override {
+      return first(chain + 1) - first(chain);
+   }
+
+   //! Records of the chain in place, i.e. little endian.
+   inline auto jacobians(const std::size_t chain) const
+        -> std::span<const CorpusJacobian> {
+      return m_records.subspan(first(chain), length(chain));
+   }
+
+   inline auto load(const std::size_t chain, JacobianChain& out) const
+        -> void override {
+      out.elemental_jacobians.clear();
+      out.elemental_jacobians.reserve(length(chain));
+      for (const CorpusJacobian& record : jacobians(chain)) {
+         const std::size_t k = out.elemental_jacobians.size();
+         out.elemental_jacobians.push_back(
+              {.i = k,
+               .j = k + 1,
+               .n = corpus_order(record.n),
+               .m = corpus_order(record.m),
+               .ku = corpus_order(record.ku),
+               .kl = corpus_order(record.kl),
+               .non_zero_elements = corpus_order(record.non_zero_elements),
+               .edges_in_dag = corpus_order(record.edges_in_dag),
+               .tangent_cost = corpus_order(record.tangent_cost),
+               .adjoint_cost = corpus_order(record.adjoint_cost)});
+      }
+      out.id = chain;
+   }
+
+ private:
+   util::MappedFile m_file {};
+   std::span<const std::uint64_t> m_index {};
+   std::span<const CorpusJacobian> m_records {};
+
+   //! Index of the first record of the chain.
+   inline auto first(const std::size_t chain) const -> std::size_t {
+      return corpus_order(m_index[chain]);
+   }
+};
+
+//! Corpus at the path for JacobianChainGenerator::set_chain_source, none if
+//! the path is empty.
+inline auto open_chain_corpus(const std::string& path)
+     -> std::unique_ptr<ChainSource> {
+   if (path.empty()) {
+      return nullptr;
+   }
+   return std::make_unique<ChainCorpus>(path);
+}
+
+}  // end namespace jcdp
+
+// >>>>>>>>>>>>>>>> INCLUDE TEMPLATE AND INLINE DEFINITIONS <<<<<<<<<<<<<<<<< //
+
+#endif  // JCDP_CHAIN_CORPUS_HPP_
@@ -0,0 +1,43 @@
+/******************************************************************************
+ * @file jcdp/chain_source.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides an interface
+ *        for stored Jacobian chains that the generator can return instead
+ *        of random ones.
+ ******************************************************************************/
+
+#ifndef JCDP_CHAIN_SOURCE_HPP_
+#define JCDP_CHAIN_SOURCE_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <cstddef>
+
+#include "jcdp/jacobian_chain.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp {
+
+/******************************************************************************
+ * @brief Fixed set of Jacobian chains, e.g. a chain corpus.
+ ******************************************************************************/
+class ChainSource {
+ public:
+   virtual ~ChainSource() = default;
+
+   //! Amount of chains.
+   virtual auto size() const -> std::size_t = 0;
+
+   virtual auto length(std::size_t chain) const -> std::size_t = 0;
+
+   //! Replace the elemental Jacobians of the chain with the ones of the
+   //! given chain, whose index becomes the id.
+   virtual auto load(std::size_t chain, JacobianChain& out) const -> void = 0;
+};
+
+}  // end namespace jcdp
+
+// >>>>>>>>>>>>>>>> INCLUDE TEMPLATE AND INLINE DEFINITIONS <<<<<<<<<<<<<<<<< //
+
+#endif  // JCDP_CHAIN_SOURCE_HPP_
@@ -4,21 +4,32 @@
 #include <cstddef>
 
 #include "jcdp/operation.hpp"
+#include "jcdp/packed_operation.hpp"
 
 namespace jcdp {
 
 /* ========================= CONFIGURATION ========================= */
 
-constexpr int MAX_SEQUENCE_LENGTH = 20; // FIXED FOR LIMITED TESTING. SHOULD BE ADJUSTABLE
+// Buffers on the device have a fixed size. The scheduling kernel is compiled
+// for several capacities (see branch_and_bound_gpu_offload.cpp) and the host
+// picks the smallest one that fits, these are the largest ones.
+constexpr std::size_t MAX_SEQUENCE_LENGTH = 64;
+constexpr std::size_t MAX_DEVICE_THREADS = 32;
 
 /* ========================= DEVICE SEQUENCE ======================== */
 
-struct DeviceSequence {
-   Operation ops[MAX_SEQUENCE_LENGTH];
+// Packed operations halve the size of the sequence that is mapped by value
+template<std::size_t MaxLength>
+struct BasicDeviceSequence {
+   static_assert(MaxLength <= MAX_PACKED_INDEX);
+
+   PackedOperation ops[MaxLength];
    std::size_t length;
    std::size_t best_makespan_output;
 };
 
+using DeviceSequence = BasicDeviceSequence<MAX_SEQUENCE_LENGTH>;
+
 /* ========================= DEVICE FUNCTIONS ======================= */
 
 // #pragma omp declare target
@@ -30,7 +41,7 @@ inline DeviceSequence device_make_max() {
    DeviceSequence seq {};
    seq.length = 1;
 
-   Operation& op = seq.ops[0];
+   PackedOperation& op = seq.ops[0];
 
    op.fma = static_cast<std::size_t>(-1);  // SIZE_MAX without <limits>
    op.start_time = 0;
@@ -40,7 +51,9 @@ inline DeviceSequence device_make_max() {
    return seq;
 }
 
-inline std::size_t device_sequential_makespan(const DeviceSequence& seq) {
+template<std::size_t MaxLength>
+inline std::size_t device_sequential_makespan(
+     const BasicDeviceSequence<MaxLength>& seq) {
    std::size_t cost = 0;
    for (std::size_t i = 0; i < seq.length; ++i) {
       cost += seq.ops[i].fma;
@@ -48,13 +61,14 @@ inline std::size_t device_sequential_makespan(const DeviceSequence& seq) {
    return cost;
 }
 
+template<std::size_t MaxLength>
 inline std::size_t makespan(
-     const DeviceSequence& seq,
+     const BasicDeviceSequence<MaxLength>& seq,
      std::size_t thread = static_cast<std::size_t>(-1)) {
    std::size_t cost = 0;
 
    for (std::size_t i = 0; i < seq.length; ++i) {
-      const Operation& op = seq.ops[i];
+      const PackedOperation& op = seq.ops[i];
 
       if (thread == static_cast<std::size_t>(-1) || op.thread == thread) {
          if (op.is_scheduled) {
@@ -67,7 +81,9 @@ inline std::size_t makespan(
    return cost;
 }
 
-inline std::size_t count_accumulations(const DeviceSequence& seq) {
+template<std::size_t MaxLength>
+inline std::size_t count_accumulations(
+     const BasicDeviceSequence<MaxLength>& seq) {
    std::size_t count = 0;
    for (std::size_t i = 0; i < seq.length; ++i) {
       if (seq.ops[i].action == Action::ACCUMULATION) {
@@ -79,7 +95,9 @@ inline std::size_t count_accumulations(const DeviceSequence& seq) {
 
 /* ------------------ Sequential Makespan --------------------------- */
 
-inline std::size_t sequential_makespan(const DeviceSequence& seq) {
+template<std::size_t MaxLength>
+inline std::size_t sequential_makespan(
+     const BasicDeviceSequence<MaxLength>& seq) {
    std::size_t sum = 0;
    for (std::size_t i = 0; i < seq.length; ++i) {
       sum += seq.ops[i].fma;
@@ -89,7 +107,8 @@ inline std::size_t sequential_makespan(const DeviceSequence& seq) {
 
 /* ------------------ Is Scheduled ---------------------------------- */
 
-inline bool is_scheduled(const DeviceSequence& seq) {
+template<std::size_t MaxLength>
+inline bool is_scheduled(const BasicDeviceSequence<MaxLength>& seq) {
    for (std::size_t i = 0; i < seq.length; ++i) {
       if (!seq.ops[i].is_scheduled) {
          return false;
@@ -100,7 +119,9 @@ inline bool is_scheduled(const DeviceSequence& seq) {
 
 /* ------------------ Is Schedulable -------------------------------- */
 
-inline bool is_schedulable(const DeviceSequence& seq, std::size_t op_idx) {
+template<std::size_t MaxLength>
+inline bool is_schedulable(
+     const BasicDeviceSequence<MaxLength>& seq, std::size_t op_idx) {
    for (std::size_t i = 0; i < seq.length; ++i) {
       if (seq.ops[op_idx] < seq.ops[i]) {
          if (!seq.ops[i].is_scheduled) {
@@ -113,8 +134,9 @@ inline bool is_schedulable(const DeviceSequence& seq, std::size_t op_idx) {
 
 /* ------------------ Earliest Start -------------------------------- */
 
+template<std::size_t MaxLength>
 inline std::size_t earliest_start(
-     const DeviceSequence& seq, std::size_t op_idx) {
+     const BasicDeviceSequence<MaxLength>& seq, std::size_t op_idx) {
    std::size_t max_time = 0;
 
    for (std::size_t i = 0; i < seq.length; ++i) {
@@ -130,7 +152,9 @@ inline std::size_t earliest_start(
 
 /* ------------------ Critical Path --------------------------------- */
 
-inline std::size_t device_critical_path(const DeviceSequence& seq) {
+template<std::size_t MaxLength>
+inline std::size_t device_critical_path(
+     const BasicDeviceSequence<MaxLength>& seq) {
 
    std::size_t max_cp = 0;
 
@@ -145,12 +169,12 @@ inline std::size_t device_critical_path(const DeviceSequence& seq) {
 
          for (std::size_t j = 0; j < seq.length; ++j) {
             if (seq.ops[j] < seq.ops[current]) {
-               const std::size_t parent_end = seq.ops[j].start_time +
-                                              seq.ops[j].fma;
-
-               if (parent_end > time) {
-                  time = parent_end;
+               // Same as Sequence::critical_path(), the parent can't start
+               // before its operands are available
+               if (seq.ops[j].start_time > time) {
+                  time = seq.ops[j].start_time;
                }
+               time += seq.ops[j].fma;
 
                current = j;
                found_parent = true;
@@ -174,15 +198,17 @@ inline std::size_t device_critical_path(const DeviceSequence& seq) {
 
 }  // namespace jcdp
 
-template<>
-struct std::formatter<jcdp::DeviceSequence> {
+template<std::size_t MaxLength>
+struct std::formatter<jcdp::BasicDeviceSequence<MaxLength>> {
    template<class ParseContext>
    constexpr auto parse(ParseContext& ctx) {
       return ctx.begin();
    }
 
    template<class FormatContext>
-   auto format(const jcdp::DeviceSequence& seq, FormatContext& ctx) {
+   auto format(
+        const jcdp::BasicDeviceSequence<MaxLength>& seq,
+        FormatContext& ctx) const {
       auto out = ctx.out();
       for (std::size_t i = 0; i < seq.length; ++i) {
          out = std::format_to(out, "{}\n", seq.ops[i]);
@@ -14,12 +14,16 @@
 #include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <memory>
+#include <numeric>
 #include <optional>
 #include <random>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "jcdp/chain_source.hpp"
 #include "jcdp/jacobian.hpp"
 #include "jcdp/jacobian_chain.hpp"
 #include "jcdp/util/properties.hpp"
@@ -53,6 +57,42 @@ class JacobianChainGenerator : public util::Properties {
            "number of non-zero entries and bandwidth.");
       register_property(
            m_seed, "seed", "Seed for the random number generator.");
+      register_property(
+           m_corpus_path, "chain_corpus",
+           "Binary chain corpus to read the chains from instead of "
+           "generating them (length, amount and the ranges are ignored).");
+   }
+
+   //! Path of the chain_corpus property, empty if the chains are generated.
+   inline auto corpus_path() const -> const std::string& {
+      return m_corpus_path;
+   }
+
+   //! Stored chains to return instead of random ones, e.g. the corpus at
+   //! corpus_path() (see open_chain_corpus). Takes effect with init().
+   inline auto set_chain_source(std::unique_ptr<ChainSource> source) -> void {
+      m_corpus = std::move(source);
+   }
+
+   //! Prepare the source of the chains, i.e. the corpus (if any) or the RNG.
+   inline auto init() -> void {
+      init_rng();
+      if (!m_corpus_path.empty() && !m_corpus) {
+         throw std::runtime_error(
+              "chain_corpus is set, but no chain source was opened");
+      }
+      if (!m_corpus) {
+         return;
+      }
+
+      // Chains of the same length form one batch, like generated ones
+      m_corpus_order.resize(m_corpus->size());
+      std::iota(m_corpus_order.begin(), m_corpus_order.end(), 0);
+      std::ranges::stable_sort(
+           m_corpus_order, {}, [this](const std::size_t c) {
+              return m_corpus->length(c);
+           });
+      m_corpus_idx = 0;
    }
 
    inline auto init_rng() -> void {
@@ -64,11 +104,16 @@ class JacobianChainGenerator : public util::Properties {
       m_density_distribution.param(real_bounds(m_density_range));
    }
 
-   //! Generate a random Jacobian chain.
+   //! Generate a random Jacobian chain. With a corpus, the next chain of
+   //! the current length is loaded instead. Once all of them were returned,
+   //! the chain is left untouched and the next length becomes current.
    inline auto next(JacobianChain& chain) -> bool {
       if (empty()) {
          return false;
       }
+      if (uses_corpus()) {
+         return next_from_corpus(chain);
+      }
 
       chain.elemental_jacobians.clear();
       chain.elemental_jacobians.reserve(m_chain_lengths[length_idx]);
@@ -94,10 +139,26 @@ class JacobianChainGenerator : public util::Properties {
    }
 
    inline auto current_length() -> std::size_t {
+      if (uses_corpus()) {
+         return m_corpus->length(m_corpus_order[m_corpus_idx]);
+      }
       return m_chain_lengths[length_idx];
    }
 
+   //! Length of the longest chains that will be generated.
+   inline auto max_length() const -> std::size_t {
+      if (uses_corpus()) {
+         return m_corpus_order.empty()
+                     ? 0
+                     : m_corpus->length(m_corpus_order.back());
+      }
+      return std::ranges::max(m_chain_lengths);
+   }
+
    inline auto empty() -> bool {
+      if (uses_corpus()) {
+         return m_corpus_idx >= m_corpus_order.size();
+      }
       const std::size_t idx = length_idx * m_amount + batch_idx;
       return idx >= m_amount * m_chain_lengths.size();
    }
@@ -115,6 +176,7 @@ class JacobianChainGenerator : public util::Properties {
       std::random_device rd;
       return rd();
    }()};
+   std::string m_corpus_path {};
 
    // Internal RNG state
    std::mt19937_64 m_gen;
@@ -127,6 +189,30 @@ class JacobianChainGenerator : public util::Properties {
    std::size_t batch_idx {0};
    std::size_t length_idx {0};
 
+   // Corpus chains, by length
+   std::unique_ptr<ChainSource> m_corpus {};
+   std::vector<std::size_t> m_corpus_order {};
+   std::size_t m_corpus_idx {0};
+   bool m_corpus_batch_done {false};
+
+   inline auto uses_corpus() const -> bool {
+      return m_corpus != nullptr;
+   }
+
+   inline auto next_from_corpus(JacobianChain& chain) -> bool {
+      if (m_corpus_batch_done) {
+         m_corpus_batch_done = false;
+         return false;
+      }
+
+      const std::size_t length = current_length();
+
+      m_corpus->load(m_corpus_order[m_corpus_idx], chain);
+      ++m_corpus_idx;
+      m_corpus_batch_done = empty() || current_length() != length;
+      return true;
+   }
+
    using int_param_t = std::uniform_int_distribution<std::size_t>::param_type;
    using real_param_t = std::uniform_real_distribution<double>::param_type;
 
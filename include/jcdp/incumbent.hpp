@@ -0,0 +1,105 @@
+/******************************************************************************
+ * @file jcdp/incumbent.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides the best known
+ *        solution (incumbent) of a branch & bound search which is shared
+ *        between all tasks of the optimizer and the schedulers they call.
+ ******************************************************************************/
+
+#ifndef JCDP_INCUMBENT_HPP_
+#define JCDP_INCUMBENT_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <utility>
+
+#include "jcdp/sequence.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp {
+
+/******************************************************************************
+ * @brief Best makespan found so far and the corresponding sequence.
+ *
+ * The makespan is an atomic that is only ever lowered (CAS-min), so it can be
+ * polled without synchronization for pruning. The sequence itself is only
+ * copied (under a lock) when the makespan actually improved.
+ ******************************************************************************/
+class Incumbent {
+ public:
+   Incumbent() = default;
+
+   Incumbent(const Incumbent&) = delete;
+   auto operator=(const Incumbent&) -> Incumbent& = delete;
+
+   //! Forget the current solution (keeping its storage). Not thread-safe.
+   inline auto reset() -> void {
+      m_makespan.store(MAX_MAKESPAN, std::memory_order_relaxed);
+      m_sequence.clear();
+      m_sequence.push_back(Sequence::MAX_OPERATION);
+      m_sequence_makespan = MAX_MAKESPAN;
+   }
+
+   //! Best makespan published so far.
+   inline auto makespan() const -> std::size_t {
+      return m_makespan.load(std::memory_order_relaxed);
+   }
+
+   //! Publish a solution. Returns false if it doesn't improve the incumbent.
+   inline auto update(const Sequence& sequence, const std::size_t makespan)
+        -> bool {
+      std::size_t current = m_makespan.load(std::memory_order_relaxed);
+      do {
+         if (makespan >= current) {
+            return false;
+         }
+      } while (!m_makespan.compare_exchange_weak(
+           current, makespan, std::memory_order_relaxed));
+
+      // Another task may have published an even better solution in between
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (makespan < m_sequence_makespan) {
+         m_sequence = sequence;
+         m_sequence_makespan = makespan;
+         if (m_observer) {
+            m_observer(m_sequence, makespan);
+         }
+      }
+      return true;
+   }
+
+   //! Called (under the lock, i.e. one at a time and without access to
+   //! sequence()) with every solution that becomes the new incumbent. Set it
+   //! before the search starts, an empty function removes it.
+   inline auto set_observer(
+        std::function<void(const Sequence&, std::size_t)> observer) -> void {
+      m_observer = std::move(observer);
+   }
+
+   //! Copy of the best sequence published so far.
+   inline auto sequence() const -> Sequence {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_sequence;
+   }
+
+ private:
+   static constexpr std::size_t MAX_MAKESPAN =
+        std::numeric_limits<std::size_t>::max();
+
+   std::atomic<std::size_t> m_makespan {MAX_MAKESPAN};
+
+   mutable std::mutex m_mutex;
+   Sequence m_sequence {Sequence::make_max()};
+   std::size_t m_sequence_makespan {MAX_MAKESPAN};
+   std::function<void(const Sequence&, std::size_t)> m_observer {};
+};
+
+}  // end namespace jcdp
+
+#endif  // JCDP_INCUMBENT_HPP_
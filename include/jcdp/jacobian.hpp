@@ -44,7 +44,8 @@ struct Jacobian {
    //! Cost of a single adjoint evaluation (x_(1) = y_(1) * F').
    std::size_t adjoint_cost {0};
 
-   //! Whether the Jacobian is already accumulated or not.
+   //! Whether the Jacobian is already accumulated or not. Chains keep the
+   //! state of their Jacobians themselves, see JacobianChain::get_jacobian().
    bool is_accumulated {false};
 
    //! Whether the Jacobian is already used in an elimination.
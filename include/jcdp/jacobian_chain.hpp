@@ -10,7 +10,6 @@
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
-#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <vector>
@@ -22,9 +21,16 @@
 
 namespace jcdp {
 
+/******************************************************************************
+ * @brief Chain of elemental Jacobians and the state of all its sub-chains.
+ *
+ * The sub-chain from i to j (j > i) is not stored but derived on demand from
+ * prefix sums over the elemental Jacobians. Whether the Jacobian of a
+ * (sub-)chain is accumulated or used is kept in two bitsets, so apply() and
+ * revert() only flip bits and a copy of the chain is small.
+ ******************************************************************************/
 struct JacobianChain {
    std::vector<Jacobian> elemental_jacobians {};
-   std::vector<Jacobian> sub_chains {};
    std::vector<std::size_t> optimized_costs {};
    std::size_t id {0};
 
@@ -32,67 +38,73 @@ struct JacobianChain {
       return elemental_jacobians.size();
    }
 
+   //! Pre-size the buffers for chains of up to max_length Jacobians.
+   inline auto reserve(const std::size_t max_length) -> void {
+      elemental_jacobians.reserve(max_length);
+      m_edges_in_dag.reserve(max_length + 1);
+      m_tangent_cost.reserve(max_length + 1);
+      m_adjoint_cost.reserve(max_length + 1);
+      m_accumulated.reserve(max_length * (max_length + 1) / 2);
+      m_used.reserve(max_length * (max_length + 1) / 2);
+   }
+
+   //! Prepare the sub-chains of the elemental Jacobians, none of which is
+   //! accumulated or used yet.
    inline auto init_subchains() -> void {
       const std::size_t len = length();
-      sub_chains.resize(len * (len - 1) / 2);
-
-      for (std::size_t j = 0; j < len; ++j) {
-         for (std::size_t i = 0; i < j; ++i) {
-            const std::size_t idx = j * (j - 1) / 2 + i;
-
-            sub_chains[idx].i = elemental_jacobians[i].i;
-            sub_chains[idx].j = elemental_jacobians[j].j;
-            sub_chains[idx].n = elemental_jacobians[i].n;
-            sub_chains[idx].m = elemental_jacobians[j].m;
-
-            for (std::size_t k = i; k <= j; ++k) {
-               sub_chains[idx].edges_in_dag +=
-                    elemental_jacobians[k].edges_in_dag;
-               sub_chains[idx].tangent_cost +=
-                    elemental_jacobians[k].tangent_cost;
-               sub_chains[idx].adjoint_cost +=
-                    elemental_jacobians[k].adjoint_cost;
-            }
-         }
-      }
+      prefix_sum(m_edges_in_dag, &Jacobian::edges_in_dag);
+      prefix_sum(m_tangent_cost, &Jacobian::tangent_cost);
+      prefix_sum(m_adjoint_cost, &Jacobian::adjoint_cost);
+
+      // Reset (not just resize) as the chain may be reused for another one
+      m_accumulated.assign(len * (len + 1) / 2, false);
+      m_used.assign(len * (len + 1) / 2, false);
+   }
+
+   inline auto is_accumulated(const std::size_t j, const std::size_t i) const
+        -> bool {
+      return m_accumulated[index(j, i)];
+   }
+
+   inline auto is_used(const std::size_t j, const std::size_t i) const
+        -> bool {
+      return m_used[index(j, i)];
    }
 
    inline auto apply(const Operation& op) -> bool {
-      Jacobian& ij_jac = get_jacobian(op.j, op.i);
-      if (ij_jac.is_accumulated) {
+      const std::size_t ij = index(op.j, op.i);
+      if (m_accumulated[ij]) {
          return false;
       }
 
       if (op.action != Action::ACCUMULATION) {
-         Jacobian& jk_jac = get_jacobian(op.j, op.k + 1);
-         Jacobian& ki_jac = get_jacobian(op.k, op.i);
+         const std::size_t jk = index(op.j, op.k + 1);
+         const std::size_t ki = index(op.k, op.i);
 
          switch (op.mode) {
             case Mode::TANGENT: {
-               if (!ki_jac.is_accumulated || ki_jac.is_used ||
-                   jk_jac.is_accumulated) {
+               if (!m_accumulated[ki] || m_used[ki] || m_accumulated[jk]) {
                   return false;
                }
-               jk_jac.is_accumulated = true;
-               ki_jac.is_used = true;
+               m_accumulated[jk] = true;
+               m_used[ki] = true;
             } break;
 
             case Mode::ADJOINT: {
-               if (!jk_jac.is_accumulated || jk_jac.is_used ||
-                   ki_jac.is_accumulated) {
+               if (!m_accumulated[jk] || m_used[jk] || m_accumulated[ki]) {
                   return false;
                }
-               ki_jac.is_accumulated = true;
-               jk_jac.is_used = true;
+               m_accumulated[ki] = true;
+               m_used[jk] = true;
             } break;
 
             case Mode::NONE: {
-               if (!jk_jac.is_accumulated || jk_jac.is_used ||
-                   !ki_jac.is_accumulated || ki_jac.is_used) {
+               if (!m_accumulated[jk] || m_used[jk] || !m_accumulated[ki] ||
+                   m_used[ki]) {
                   return false;
                }
-               jk_jac.is_used = true;
-               ki_jac.is_used = true;
+               m_used[jk] = true;
+               m_used[ki] = true;
             } break;
 
             default: {
@@ -101,39 +113,39 @@ struct JacobianChain {
          }
       }
 
-      ij_jac.is_accumulated = true;
+      m_accumulated[ij] = true;
       return true;
    }
 
    inline auto revert(const Operation& op) {
-      Jacobian& ij_jac = get_jacobian(op.j, op.i);
-      assert(ij_jac.is_accumulated);
-      ij_jac.is_accumulated = false;
+      const std::size_t ij = index(op.j, op.i);
+      assert(m_accumulated[ij]);
+      m_accumulated[ij] = false;
 
       if (op.action != Action::ACCUMULATION) {
-         Jacobian& jk_jac = get_jacobian(op.j, op.k + 1);
-         Jacobian& ki_jac = get_jacobian(op.k, op.i);
+         const std::size_t jk = index(op.j, op.k + 1);
+         const std::size_t ki = index(op.k, op.i);
 
          if (op.mode == Mode::TANGENT) {
-            jk_jac.is_accumulated = false;
+            m_accumulated[jk] = false;
          } else {
-            jk_jac.is_used = false;
+            m_used[jk] = false;
          }
 
          if (op.mode == Mode::ADJOINT) {
-            ki_jac.is_accumulated = false;
+            m_accumulated[ki] = false;
          } else {
-            ki_jac.is_used = false;
+            m_used[ki] = false;
          }
       }
    }
 
    inline auto accumulated_jacobians() const -> std::size_t {
-      return std::count_if(
-           elemental_jacobians.cbegin(), elemental_jacobians.cend(),
-           [](const Jacobian& jac) -> bool {
-              return jac.is_accumulated;
-           });
+      std::size_t count = 0;
+      for (std::size_t j = 0; j < length(); ++j) {
+         count += is_accumulated(j, j);
+      }
+      return count;
    }
 
    inline auto longest_possible_sequence() const -> std::size_t {
@@ -149,33 +161,56 @@ struct JacobianChain {
       return len;
    }
 
- private:
-   template<typename Self>
-   inline static auto get_jacobian_impl(
-        Self& self, const std::size_t j, const std::size_t i)
-        -> decltype(auto) {
-      assert(j < self.elemental_jacobians.size());
-      assert(i < self.elemental_jacobians.size());
+   //! Jacobian of the sub-chain from i to j, including its current state.
+   //! Sub-chains have no sparsity information.
+   inline auto get_jacobian(const std::size_t j, const std::size_t i) const
+        -> Jacobian {
+      assert(j < elemental_jacobians.size());
       assert(j >= i);
 
+      Jacobian jac;
       if (j == i) {
-         return self.elemental_jacobians[j];
+         jac = elemental_jacobians[j];
+      } else {
+         assert(m_edges_in_dag.size() == length() + 1);
+         jac.i = elemental_jacobians[i].i;
+         jac.j = elemental_jacobians[j].j;
+         jac.n = elemental_jacobians[i].n;
+         jac.m = elemental_jacobians[j].m;
+         jac.edges_in_dag = m_edges_in_dag[j + 1] - m_edges_in_dag[i];
+         jac.tangent_cost = m_tangent_cost[j + 1] - m_tangent_cost[i];
+         jac.adjoint_cost = m_adjoint_cost[j + 1] - m_adjoint_cost[i];
       }
-
-      const std::size_t idx = j * (j - 1) / 2 + i;
-      assert(self.sub_chains.size() > idx);
-      return self.sub_chains[idx];
+      jac.is_accumulated = is_accumulated(j, i);
+      jac.is_used = is_used(j, i);
+      return jac;
    }
 
- public:
-   inline auto get_jacobian(const std::size_t j, const std::size_t i)
-        -> Jacobian& {
-      return get_jacobian_impl(*this, j, i);
+ private:
+   //! Sums of the elemental Jacobians before each index (and of all)
+   std::vector<std::size_t> m_edges_in_dag {};
+   std::vector<std::size_t> m_tangent_cost {};
+   std::vector<std::size_t> m_adjoint_cost {};
+
+   //! State of the (sub-)chain from i to j at index(j, i)
+   std::vector<bool> m_accumulated {};
+   std::vector<bool> m_used {};
+
+   inline auto index(const std::size_t j, const std::size_t i) const
+        -> std::size_t {
+      assert(j < length());
+      assert(i <= j);
+      return j * (j + 1) / 2 + i;
    }
 
-   inline auto get_jacobian(const std::size_t j, const std::size_t i) const
-        -> const Jacobian& {
-      return get_jacobian_impl(*this, j, i);
+   inline auto prefix_sum(
+        std::vector<std::size_t>& sums, std::size_t Jacobian::* field)
+        -> void {
+      sums.resize(length() + 1);
+      sums[0] = 0;
+      for (std::size_t k = 0; k < length(); ++k) {
+         sums[k + 1] = sums[k] + elemental_jacobians[k].*field;
+      }
    }
 };
 
@@ -11,6 +11,7 @@
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <chrono>
@@ -28,6 +29,7 @@
 #include "jcdp/optimizer/optimizer.hpp"
 #include "jcdp/scheduler/scheduler.hpp"
 #include "jcdp/scheduler/bnb_block.hpp"
+#include "jcdp/scheduler/schedule_cache.hpp"
 #include "jcdp/sequence.hpp"
 #include "jcdp/util/timer.hpp"
 
@@ -45,6 +47,18 @@ class BnBBlockOptimizer : public Optimizer, public util::Timer {
       register_property(
            m_time_to_solve, "time_to_solve",
            "Maximal runtime for the branch & bound solver in seconds.");
+      register_property(
+           m_batch_size, "batch_size",
+           "Maximal amount of sequences scheduled by one kernel launch "
+           "(0 = all at once).");
+      register_property(
+           m_split_depth, "gpu_split_depth",
+           "Depth at which the search trees are split into work items for "
+           "all device threads (0 = one device thread per sequence).");
+      register_property(
+           m_devices, "gpu_devices",
+           "Amount of devices the batches are distributed over (0 = all "
+           "visible devices).");
    }
 
    virtual ~BnBBlockOptimizer() = default;
@@ -62,6 +76,8 @@ class BnBBlockOptimizer : public Optimizer, public util::Timer {
 
       m_leafs = 0;
       m_updated_makespan = 0;
+      m_schedule_cache.clear();
+      sequences.clear();
       m_pruned_branches.clear();
       m_pruned_branches.resize(m_chain.longest_possible_sequence() + 1);
    }
@@ -76,8 +92,9 @@ class BnBBlockOptimizer : public Optimizer, public util::Timer {
       while (++accs <= m_length) {
          Sequence sequence {};
          std::vector<OpPair> eliminations {};
+         std::vector<std::size_t> finish_times {};
          JacobianChain chain = m_chain;
-         add_accumulation(sequence, chain, accs, eliminations);
+         add_accumulation(sequence, chain, accs, eliminations, finish_times);
       }
       schedule_all_late();
       return m_optimal_sequence;
@@ -108,14 +125,19 @@ class BnBBlockOptimizer : public Optimizer, public util::Timer {
    std::size_t m_leafs {0};
    std::vector<std::size_t> m_pruned_branches {};
    std::size_t m_updated_makespan {0};
+   std::size_t m_batch_size {0};
+   std::size_t m_split_depth {0};
+   std::size_t m_devices {0};
    scheduler::BnBBlockScheduler* m_scheduler;
    std::vector<Sequence> sequences;
+   scheduler::ScheduleCache m_schedule_cache {};
 
    using Optimizer::init;
 
    inline auto add_accumulation(
         Sequence& sequence, JacobianChain& chain, const std::size_t accs,
-        std::vector<OpPair>& eliminations, std::size_t j = 0) -> void {
+        std::vector<OpPair>& eliminations,
+        std::vector<std::size_t>& finish_times, std::size_t j = 0) -> void {
       if (accs > 0) {
          for (; j < m_chain.length(); ++j) {
             const Operation op = cheapest_accumulation(j);
@@ -125,9 +147,12 @@ class BnBBlockOptimizer : public Optimizer, public util::Timer {
 
             push_possible_eliminations(chain, eliminations, op.j, op.i);
             sequence.push_back(std::move(op));
+            push_finish_time(sequence, finish_times);
 
-            add_accumulation(sequence, chain, accs - 1, eliminations, j + 1);
+            add_accumulation(
+                 sequence, chain, accs - 1, eliminations, finish_times, j + 1);
 
+            finish_times.pop_back();
             sequence.pop_back();
             eliminations.pop_back();
             chain.revert(op);
@@ -137,16 +162,23 @@ class BnBBlockOptimizer : public Optimizer, public util::Timer {
          Sequence task_sequence = sequence;
          JacobianChain task_chain = chain;
          std::vector<OpPair> task_eliminations = eliminations;
+         std::vector<std::size_t> task_finish_times = finish_times;
+         const std::size_t critical_path = std::ranges::max(finish_times);
 
          #pragma omp task default(none) firstprivate(task_sequence)            \
-         firstprivate(task_chain, task_eliminations)
-         add_elimination(task_sequence, task_chain, task_eliminations);
+         firstprivate(task_chain, task_eliminations)                           \
+         firstprivate(task_finish_times, critical_path)
+         add_elimination(
+              task_sequence, task_chain, task_eliminations, task_finish_times,
+              critical_path);
       }
    }
 
    inline auto add_elimination(
         Sequence& sequence, JacobianChain& chain,
-        std::vector<OpPair>& eliminations, std::size_t elim_idx = 0) -> void {
+        std::vector<OpPair>& eliminations,
+        std::vector<std::size_t>& finish_times, const std::size_t critical_path,
+        std::size_t elim_idx = 0) -> void {
 
       // Return if time's up
       if (!remaining_time()) {
@@ -154,19 +186,30 @@ class BnBBlockOptimizer : public Optimizer, public util::Timer {
       }
 
       // Check if we accumulated the entire jacobian
-      if (chain.get_jacobian(chain.length() - 1, 0).is_accumulated) {
+      if (chain.is_accumulated(chain.length() - 1, 0)) {
          assert(elim_idx == eliminations.size() - 1);
          assert(!eliminations[elim_idx][0].has_value());
          assert(!eliminations[elim_idx][1].has_value());
 
+         // Sequences with the same precedence DAG as an already gathered
+         // one have the same optimal schedule
+         const bool inserted = m_schedule_cache.insert(
+              scheduler::ScheduleCache::make_key(sequence, m_usable_threads),
+              {.makespan = critical_path});
+         if (!inserted) {
+            return;
+         }
+
          // Instead of scheduling here, we gather the sequences together
          #pragma omp critical
          sequences.push_back(sequence);
          return;
       }
 
-      // Check critical path as lower bound
-      const std::size_t lower_bound = sequence.critical_path();
+      // Check critical path as lower bound. It is maintained incrementally
+      // via the finish times of the operations (see push_finish_time).
+      const std::size_t lower_bound = critical_path;
+      assert(lower_bound == sequence.critical_path());
       if (lower_bound >= m_makespan || lower_bound > m_upper_bound) {
          std::size_t& prune_counter = m_pruned_branches[sequence.length()];
 
@@ -190,9 +233,14 @@ class BnBBlockOptimizer : public Optimizer, public util::Timer {
 
             push_possible_eliminations(chain, eliminations, op.j, op.i);
             sequence.push_back(op);
+            const std::size_t finish_time = push_finish_time(
+                 sequence, finish_times);
 
-            add_elimination(sequence, chain, eliminations, elim_idx + 1);
+            add_elimination(
+                 sequence, chain, eliminations, finish_times,
+                 std::max(critical_path, finish_time), elim_idx + 1);
 
+            finish_times.pop_back();
             sequence.pop_back();
             eliminations.pop_back();
             chain.revert(op);
@@ -200,8 +248,26 @@ class BnBBlockOptimizer : public Optimizer, public util::Timer {
       }
    }
 
+   //! Pushes the finish time of the last operation in the sequence, assuming
+   //! that every operation starts as soon as its operands are available. The
+   //! maximum over all finish times is the critical path of the sequence.
+   inline auto push_finish_time(
+        const Sequence& sequence, std::vector<std::size_t>& finish_times)
+        -> std::size_t {
+      assert(finish_times.size() + 1 == sequence.length());
+      const std::size_t op_idx = sequence.length() - 1;
+
+      std::size_t start_time = sequence[op_idx].start_time;
+      sequence.for_each_child(op_idx, [&](const std::size_t child) {
+         start_time = std::max(start_time, finish_times[child]);
+      });
+
+      finish_times.push_back(start_time + sequence[op_idx].fma);
+      return finish_times.back();
+   }
+
    inline auto cheapest_accumulation(const std::size_t j) -> Operation {
-      const Jacobian& jac = m_chain.get_jacobian(j, j);
+      const Jacobian jac = m_chain.get_jacobian(j, j);
       Operation op {
            .action = Action::ACCUMULATION,
            .mode = Mode::TANGENT,
@@ -228,10 +294,22 @@ class BnBBlockOptimizer : public Optimizer, public util::Timer {
     */
    inline auto schedule_all_late() -> void {
       std::println("To schedule: {}", sequences.size());
+      if (sequences.empty()) {
+         return;
+      }
+
+      m_scheduler->set_split_depth(m_split_depth);
+      m_scheduler->set_devices(m_devices);
+      const std::size_t index = m_scheduler->schedule_gpu(
+           sequences, m_usable_threads, m_makespan, m_batch_size);
+      m_leafs += sequences.size();
+      if (index == sequences.size()) {
+         return;
+      }
 
-      int index = m_scheduler->schedule_gpu(sequences, m_usable_threads, m_makespan);
       m_optimal_sequence = sequences[index];
       m_makespan = m_optimal_sequence.makespan();
+      m_updated_makespan++;
    }
 
    /*
@@ -290,15 +368,15 @@ class BnBBlockOptimizer : public Optimizer, public util::Timer {
       if (op_j < chain.length() - 1) {
          const std::size_t k = op_j;
          const std::size_t i = op_i;
-         const Jacobian& ki_jac = chain.get_jacobian(k, i);
+         const Jacobian ki_jac = chain.get_jacobian(k, i);
 
          // Add multiplication if possible
          std::size_t j;
          for (j = m_chain.length() - 1; j >= k + 1; --j) {
-            const Jacobian& jk_jac = chain.get_jacobian(j, k + 1);
-            if (!jk_jac.is_accumulated || jk_jac.is_used) {
+            if (!chain.is_accumulated(j, k + 1) || chain.is_used(j, k + 1)) {
                continue;
             }
+            const Jacobian jk_jac = chain.get_jacobian(j, k + 1);
 
             ops[0] = Operation {
                  .action = Action::MULTIPLICATION,
@@ -312,7 +390,7 @@ class BnBBlockOptimizer : public Optimizer, public util::Timer {
 
          // Add tangent elimination if multiplication wasn't possible
          if (k + 1 == ++j && m_matrix_free) {
-            const Jacobian& jk_jac = chain.get_jacobian(j, k + 1);
+            const Jacobian jk_jac = chain.get_jacobian(j, k + 1);
             assert(!jk_jac.is_accumulated && !jk_jac.is_used);
 
             ops[0] = Operation {
@@ -329,15 +407,15 @@ class BnBBlockOptimizer : public Optimizer, public util::Timer {
       if (op_i > 0) {
          const std::size_t k = op_i - 1;
          const std::size_t j = op_j;
-         const Jacobian& jk_jac = chain.get_jacobian(j, k + 1);
+         const Jacobian jk_jac = chain.get_jacobian(j, k + 1);
 
          // Add multiplication if possible
          std::size_t i;
          for (i = 0; i <= k; ++i) {
-            const Jacobian& ki_jac = chain.get_jacobian(k, i);
-            if (!ki_jac.is_accumulated || ki_jac.is_used) {
+            if (!chain.is_accumulated(k, i) || chain.is_used(k, i)) {
                continue;
             }
+            const Jacobian ki_jac = chain.get_jacobian(k, i);
 
             ops[1] = Operation {
                  .action = Action::MULTIPLICATION,
@@ -350,7 +428,7 @@ class BnBBlockOptimizer : public Optimizer, public util::Timer {
 
          // Add adjoint elimination if multiplication wasn't possible
          if (k == --i && m_matrix_free) {
-            const Jacobian& ki_jac = chain.get_jacobian(k, i);
+            const Jacobian ki_jac = chain.get_jacobian(k, i);
             assert(!ki_jac.is_accumulated && !ki_jac.is_used);
 
             if (m_available_memory == 0 ||
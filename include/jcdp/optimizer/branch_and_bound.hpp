@@ -11,24 +11,36 @@
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <chrono>
+#include <atomic>
 #include <cstddef>
+#include <functional>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <optional>
 #include <print>
+#include <stdexcept>
+#include <tuple>
 #include <utility>
 #include <vector>
 
+#include "jcdp/incumbent.hpp"
 #include "jcdp/jacobian.hpp"
 #include "jcdp/jacobian_chain.hpp"
 #include "jcdp/operation.hpp"
 #include "jcdp/optimizer/optimizer.hpp"
+#include "jcdp/optimizer/search_frontier.hpp"
 #include "jcdp/scheduler/scheduler.hpp"
+#include "jcdp/scheduler/schedule_cache.hpp"
 #include "jcdp/scheduler/branch_and_bound.hpp"
 #include "jcdp/sequence.hpp"
+#include "jcdp/util/instrumentation.hpp"
+#include "jcdp/util/object_pool.hpp"
 #include "jcdp/util/timer.hpp"
 
 #include "omp.h"
@@ -41,10 +53,69 @@ class BranchAndBoundOptimizer : public Optimizer, public util::Timer {
    using OpPair = std::array<std::optional<Operation>, 2>;
 
  public:
+   //! Solution that just became the incumbent, see set_progress_callback().
+   struct Progress {
+      const Sequence& sequence;
+      std::size_t makespan {0};
+      //! Seconds since the start of the current solve() or resume()
+      double elapsed_time {0};
+      std::size_t leafs {0};
+   };
+
+   //! Snapshot of the counters, which may be taken while a search runs.
+   struct Statistics {
+      std::size_t leafs {0};
+      std::size_t cache_hits {0};
+      std::size_t updated_makespan {0};
+      //! Per sequence length
+      std::vector<std::size_t> pruned_branches {};
+   };
+
    BranchAndBoundOptimizer() : Optimizer() {
       register_property(
            m_time_to_solve, "time_to_solve",
            "Maximal runtime for the branch & bound solver in seconds.");
+      register_property(
+           m_task_depth, "task_depth",
+           "Amount of eliminations up to which the branch & bound solver "
+           "spawns a new task per branch. Deeper subtrees are searched "
+           "inline by the task that reached them (0 = serial search).");
+      register_property(
+           m_use_schedule_cache, "schedule_cache",
+           "Wether the branch & bound solver memoizes the schedules of "
+           "sequences that consist of the same operations.");
+      register_property(
+           m_use_work_bound, "work_bound",
+           "Wether the branch & bound solver also prunes sequences whose "
+           "work (done plus a lower bound on the rest) spread over the "
+           "threads can't beat the incumbent, not only by critical path.");
+      register_property(
+           m_use_child_order, "child_order",
+           "Wether the branch & bound solver visits the eliminations of a "
+           "node by the critical path they lead to (then by fma) instead of "
+           "the order in which they became possible.");
+      register_property(
+           m_discrepancies, "discrepancies",
+           "Limited discrepancy passes of the branch & bound solver before "
+           "its complete search. Pass d leaves the first child at no more "
+           "than d nodes of a path, to find good incumbents early.");
+
+      m_incumbent.set_observer(
+           [this](const Sequence& sequence, const std::size_t makespan) {
+              if (!m_progress_callback) {
+                 return;
+              }
+
+              std::size_t leafs;
+              #pragma omp atomic read
+              leafs = m_leafs;
+
+              m_progress_callback(
+                   {.sequence = sequence,
+                    .makespan = makespan,
+                    .elapsed_time = elapsed_time(),
+                    .leafs = leafs});
+           });
    }
 
    virtual ~BranchAndBoundOptimizer() = default;
@@ -55,40 +126,261 @@ class BranchAndBoundOptimizer : public Optimizer, public util::Timer {
       Optimizer::init(chain);
 
       m_scheduler = sched;
-      m_optimal_sequence = Sequence::make_max();
-      m_makespan = m_optimal_sequence.makespan();
-      m_upper_bound = m_makespan;
+      m_incumbent.reset();
+      m_upper_bound = m_incumbent.makespan();
       m_timer_expired = false;
 
       m_leafs = 0;
+      m_cache_hits = 0;
       m_updated_makespan = 0;
       m_pruned_branches.clear();
       m_pruned_branches.resize(m_chain.longest_possible_sequence() + 1);
+      m_open_nodes.clear();
+      m_targets.clear();
+
+      m_sequential_cost = 0;
+      init_elimination_costs();
+      m_guide.clear();
+      m_guide_accumulations.assign(m_length, false);
+      m_guide_accs = 0;
+   }
+
+   virtual auto reserve(const std::size_t max_length) -> void override final {
+      Optimizer::reserve(max_length);
+
+      // longest_possible_sequence() never exceeds twice the chain length
+      m_pruned_branches.reserve(2 * max_length + 1);
+      m_elimination_costs.reserve(max_length + 1);
+      m_guide.reserve(2 * max_length);
+      m_guide_accumulations.reserve(max_length);
    }
 
    virtual auto solve() -> Sequence override final {
+      set_single_target();
+      m_open_nodes.clear();
+      return search([this]() {
+         add_discrepancy_passes();
+         add_accumulations();
+      });
+   }
 
-      set_timer(m_time_to_solve);
-      start_timer();
-      std::size_t accs = m_matrix_free ? 0 : (m_length - 1);
+   //! Optimize for 1 to upper_bounds.size() threads in a single pass, each
+   //! thread count with its own upper bound (as of set_upper_bound()) and
+   //! incumbent. A schedule for t threads is valid for more threads as well,
+   //! so it becomes the incumbent of all larger thread counts. A node is
+   //! pruned once no thread count can improve with it. time_to_solve applies
+   //! per thread count. Returns the best sequence of every thread count.
+   inline auto solve_sweep(const std::vector<std::size_t>& upper_bounds)
+        -> std::vector<Sequence> {
+      while (m_sweep_incumbents.size() < upper_bounds.size()) {
+         m_sweep_incumbents.push_back(std::make_unique<Incumbent>());
+      }
 
-      #pragma omp parallel default(shared)
-      #pragma omp single
-      while (++accs <= m_length) {
-         Sequence sequence {};
-         std::vector<OpPair> eliminations {};
-         JacobianChain chain = m_chain;
-         add_accumulation(sequence, chain, accs, eliminations);
+      m_targets.clear();
+      for (std::size_t t = 1; t <= upper_bounds.size(); ++t) {
+         Incumbent& incumbent = *m_sweep_incumbents[t - 1];
+         incumbent.reset();
+         m_targets.push_back(
+              {.threads = t,
+               .incumbent = &incumbent,
+               .upper_bound = upper_bounds[t - 1]});
       }
-      return m_optimal_sequence;
+
+      m_open_nodes.clear();
+      search([this]() {
+         add_discrepancy_passes();
+         add_accumulations();
+      });
+
+      std::vector<Sequence> sequences;
+      sequences.reserve(m_targets.size());
+      for (const Target& target : m_targets) {
+         sequences.push_back(target.incumbent->sequence());
+      }
+      return sequences;
+   }
+
+   //! Continue an interrupted search (see is_complete()) with a new time
+   //! budget of time_to_solve. Incumbent and counters are kept, so the
+   //! search only visits the subtrees that were still open. After
+   //! solve_sweep() all thread counts continue, the result is the one of 1.
+   //! There are no discrepancy passes, they only ever precede solve().
+   inline auto resume() -> Sequence {
+      if (m_targets.empty()) {
+         set_single_target();
+      }
+      const std::vector<FrontierNode> nodes = std::exchange(m_open_nodes, {});
+
+      // Replay the nodes on the chain before any task runs, so that nodes
+      // of a different chain are rejected upfront
+      std::vector<std::pair<SearchState*, std::size_t>> states;
+      states.reserve(nodes.size());
+      for (const FrontierNode& node : nodes) {
+         SearchState* state = m_state_pool.acquire(
+              root_state(node.accumulations));
+         bool valid = node.sequence.length() > 0;
+         for (const Operation& op : node.sequence) {
+            valid = valid && push_operation(*state, op);
+         }
+         valid = valid && node.elim_idx < state->eliminations.size();
+         states.emplace_back(state, node.elim_idx);
+         if (!valid) {
+            for (const auto& [s, elim_idx] : states) {
+               m_state_pool.release(s);
+            }
+            throw std::invalid_argument(
+                 "Search frontier does not belong to the chain");
+         }
+      }
+
+      return search([this, &states]() {
+         for (const auto& [s, elim_idx] : states) {
+            SearchState* task_state = s;
+            const std::size_t critical_path = std::ranges::max(
+                 task_state->finish_times);
+            const std::size_t next_elim_idx = elim_idx;
+            const util::TaskOrigin origin = util::TaskOrigin::spawn();
+
+            #pragma omp task default(shared) firstprivate(task_state)          \
+                             firstprivate(critical_path, next_elim_idx, origin)
+            {
+               origin.started();
+               add_elimination(*task_state, critical_path, next_elim_idx);
+               m_state_pool.release(task_state);
+            }
+         }
+      });
+   }
+
+   //! Whether the last solve() or resume() visited the entire search tree,
+   //! i.e. it was neither interrupted by the timer nor by request_stop().
+   inline auto is_complete() const -> bool {
+      return m_open_nodes.empty();
+   }
+
+   //! Open nodes and incumbent of the last solve() or resume(), e.g. to be
+   //! written with write_frontier() and resumed by another process.
+   inline auto frontier() const -> SearchFrontier {
+      SearchFrontier frontier {.nodes = m_open_nodes};
+      frontier.makespan = m_incumbent.makespan();
+      if (frontier.makespan < SearchFrontier {}.makespan) {
+         frontier.incumbent = m_incumbent.sequence();
+      }
+      return frontier;
+   }
+
+   //! Continue the given frontier with the next resume(). Call init() with
+   //! the same chain first.
+   inline auto set_frontier(SearchFrontier frontier) -> void {
+      m_open_nodes = std::move(frontier.nodes);
+      if (frontier.makespan < SearchFrontier {}.makespan) {
+         m_incumbent.update(frontier.incumbent, frontier.makespan);
+      }
+   }
+
+   //! Called with every new incumbent, e.g. to stream improving solutions.
+   //! Calls are serialized, but may come from any thread of the search.
+   inline auto set_progress_callback(
+        std::function<void(const Progress&)> callback) -> void {
+      m_progress_callback = std::move(callback);
+   }
+
+   //! Let the running search stop as if the time was up (thread-safe). The
+   //! schedulers that run at that moment finish first.
+   inline auto request_stop() -> void {
+      m_stop_requested.store(true, std::memory_order_relaxed);
+   }
+
+   inline auto statistics() const -> Statistics {
+      Statistics stats {};
+      #pragma omp atomic read
+      stats.leafs = m_leafs;
+      #pragma omp atomic read
+      stats.cache_hits = m_cache_hits;
+      #pragma omp atomic read
+      stats.updated_makespan = m_updated_makespan;
+
+      stats.pruned_branches.resize(m_pruned_branches.size());
+      for (std::size_t i = 0; i < m_pruned_branches.size(); ++i) {
+         #pragma omp atomic read
+         stats.pruned_branches[i] = m_pruned_branches[i];
+      }
+      return stats;
    }
 
    inline auto set_upper_bound(const std::size_t upper_bound) {
       m_upper_bound = upper_bound;
    }
 
+   //! Lower bound on the sum of the fma of every sequence of the chain, e.g.
+   //! DynamicProgrammingOptimizer::sequential_cost() with the same config.
+   //! Reset by init(), 0 disables it.
+   inline auto set_sequential_cost(const std::size_t sequential_cost) {
+      m_sequential_cost = sequential_cost;
+   }
+
+   //! Sequence whose operations the search visits first, e.g. the DP
+   //! sequence: its accumulations before all others, its eliminations
+   //! before the other children of a node. Steers the first dive (and the
+   //! discrepancy passes) only, the result stays the same. Reset by init().
+   inline auto set_guide(const Sequence& guide) -> void {
+      m_guide.clear();
+      m_guide_accumulations.assign(m_length, false);
+      m_guide_accs = 0;
+      for (const Operation& op : guide) {
+         // E.g. the placeholder of an incumbent without a sequence
+         if (op.action == Action::NONE) {
+            continue;
+         }
+         if (op.j >= m_length) {
+            throw std::invalid_argument("Guide does not belong to the chain");
+         }
+         if (op.action == Action::ACCUMULATION) {
+            m_guide_accumulations[op.j] = true;
+            m_guide_accs++;
+         } else if (op.action == Action::ELIMINATION) {
+            push_guided_eliminations(op);
+         } else {
+            m_guide.push_back(op);
+         }
+      }
+
+      // Only complete accumulations are searched without matrix-free modes
+      if (!m_matrix_free && m_guide_accs < m_length) {
+         m_guide_accumulations.assign(m_length, false);
+         m_guide_accs = 0;
+      }
+   }
+
+   //! The search eliminates one elemental at a time, with the same fma and
+   //! critical path as an elimination of several at once (e.g. by the DP).
+   inline auto push_guided_eliminations(const Operation& op) -> void {
+      Operation single {.action = Action::ELIMINATION, .mode = op.mode};
+      if (op.mode == Mode::TANGENT) {
+         single.i = op.i;
+         for (std::size_t e = op.k + 1; e <= op.j; ++e) {
+            single.j = e;
+            single.k = e - 1;
+            m_guide.push_back(single);
+         }
+      } else {
+         single.j = op.j;
+         for (std::size_t e = op.k + 1; e-- > op.i;) {
+            single.k = single.i = e;
+            m_guide.push_back(single);
+         }
+      }
+   }
+
+   //! The schedule cache is kept across init() calls, so repeated solves of
+   //! the same chain (e.g. for different thread counts) can share it.
+   inline auto clear_schedule_cache() -> void {
+      m_schedule_cache.clear();
+   }
+
    inline auto print_stats() -> void {
       std::println("Leafs visited (= sequences scheduled): {}", m_leafs);
+      std::println("Schedule cache hits: {}", m_cache_hits);
       std::println("Updated makespan: {}", m_updated_makespan);
       std::println(
            "Pruned branches: {}",
@@ -102,134 +394,689 @@ class BranchAndBoundOptimizer : public Optimizer, public util::Timer {
    }
 
  private:
-   Sequence m_optimal_sequence {Sequence::make_max()};
-   std::size_t m_makespan {m_optimal_sequence.makespan()};
-   std::size_t m_upper_bound {m_makespan};
+   Incumbent m_incumbent {};
+   std::size_t m_upper_bound {m_incumbent.makespan()};
    std::size_t m_leafs {0};
+   std::size_t m_cache_hits {0};
    std::vector<std::size_t> m_pruned_branches {};
    std::size_t m_updated_makespan {0};
    scheduler::Scheduler* m_scheduler;
    std::vector<Sequence> sequences;
+   std::size_t m_task_depth {2};
+   bool m_use_schedule_cache {true};
+   scheduler::ScheduleCache m_schedule_cache {};
+   bool m_use_work_bound {true};
+   std::size_t m_sequential_cost {0};
+   bool m_use_child_order {false};
+   std::size_t m_discrepancies {0};
+
+   //! Discrepancies left to the roots of the current pass
+   static constexpr std::size_t UNLIMITED = std::numeric_limits<
+        std::size_t>::max();
+   std::size_t m_discrepancy_limit {UNLIMITED};
+
+   //! See set_guide(), m_guide_accs = 0 means no guided accumulations
+   std::vector<Operation> m_guide {};
+   std::vector<bool> m_guide_accumulations {};
+   std::size_t m_guide_accs {0};
+
+   //! Prefix sums over the elementals of the cheapest fma with which an
+   //! elimination can consume them, see init_elimination_costs().
+   std::vector<std::size_t> m_elimination_costs {};
+
+   //! Thread count the search optimizes for (one, except for solve_sweep()).
+   struct Target {
+      std::size_t threads {0};
+      Incumbent* incumbent {nullptr};
+      std::size_t upper_bound {0};
+   };
+   std::vector<Target> m_targets {};
+   std::vector<std::unique_ptr<Incumbent>> m_sweep_incumbents {};
+
+   //! Roots of the subtrees an interrupted search skipped
+   std::vector<FrontierNode> m_open_nodes {};
+   std::mutex m_open_nodes_mutex {};
+   std::atomic<bool> m_stop_requested {false};
+   std::function<void(const Progress&)> m_progress_callback {};
 
    using Optimizer::init;
 
+   //! Elimination a node may branch on, see push_children().
+   struct Child {
+      Operation op {};
+      std::size_t elim_idx {0};
+      std::size_t critical_path {0};
+      bool guided {false};
+   };
+
+   //! Everything that describes a node of the search tree. Tasks get their
+   //! own copy, inline recursion modifies and restores it in place.
+   struct SearchState {
+      Sequence sequence {};
+      JacobianChain chain {};
+      std::vector<OpPair> eliminations {};
+      std::vector<std::size_t> finish_times {};
+      std::size_t accumulations {0};
+      //! Sum of the fma of the sequence
+      std::size_t work {0};
+      //! Least fma of eliminating the elementals that are still untouched
+      std::size_t remaining_eliminations {0};
+      //! How often the path may still leave the first child
+      std::size_t discrepancies {UNLIMITED};
+      //! Children of the nodes on the path, one slice per node
+      std::vector<Child> children {};
+   };
+
+   //! Storage of the copies handed to tasks is recycled, see ObjectPool.
+   util::ObjectPool<SearchState> m_state_pool {};
+   util::ObjectPool<Sequence> m_sequence_pool {};
+
+   //! Run the search from the roots that add_roots() creates.
+   template<typename F>
+   auto search(F&& add_roots) -> Sequence {
+      const util::ScopedPhase phase("bnb_search");
+      set_timer(
+           m_time_to_solve < 0 ? m_time_to_solve
+                               : m_time_to_solve * m_targets.size());
+      start_timer();
+      m_stop_requested.store(false, std::memory_order_relaxed);
+
+      // Submitted sequences are scheduled within the time of the search
+      const bool asynchronous = m_scheduler->is_asynchronous();
+      if (asynchronous) {
+         m_scheduler->set_timer(m_time_to_solve);
+         m_scheduler->start_timer();
+      }
+
+      m_state_pool.resize();
+      m_sequence_pool.resize();
+
+      #pragma omp parallel default(shared)
+      #pragma omp single
+      {
+         // Also waits for the batches an asynchronous scheduler launched
+         #pragma omp taskgroup
+         {
+            add_roots();
+         }
+         m_scheduler->wait(*m_targets.front().incumbent);
+      }
+      if (asynchronous) {
+         m_timer_expired |= !m_scheduler->finished_in_time();
+      }
+      return m_targets.front().incumbent->sequence();
+   }
+
+   inline auto set_single_target() -> void {
+      m_targets.assign(
+           1, {.threads = m_usable_threads,
+               .incumbent = &m_incumbent,
+               .upper_bound = m_upper_bound});
+   }
+
+   inline auto root_state(const std::size_t accumulations) const
+        -> SearchState {
+      return {
+           .chain = m_chain,
+           .accumulations = accumulations,
+           .remaining_eliminations = m_elimination_costs.back(),
+           .discrepancies = m_discrepancy_limit};
+   }
+
+   //! Searches with 0, ..., discrepancies - 1 discrepancies, each one after
+   //! the other such that the next pass prunes with the incumbents found.
+   inline auto add_discrepancy_passes() -> void {
+      for (std::size_t d = 0; d < m_discrepancies && !interrupted(); ++d) {
+         m_discrepancy_limit = d;
+
+         #pragma omp taskgroup
+         {
+            add_accumulations();
+         }
+      }
+      m_discrepancy_limit = UNLIMITED;
+   }
+
+   inline auto add_accumulations() -> void {
+      // Guided accumulations first, add_accumulation() skips them later.
+      // Waits for their tasks, as deferred tasks may run after all others.
+      if (m_guide_accs > 0) {
+         SearchState state = root_state(m_guide_accs);
+         for (std::size_t j = 0; j < m_length; ++j) {
+            if (m_guide_accumulations[j]) {
+               push_operation(state, cheapest_accumulation(j));
+            }
+         }
+
+         #pragma omp taskgroup
+         {
+            add_elimination_root(state);
+         }
+
+         // Any other accumulations would be a discrepancy
+         if (m_discrepancy_limit == 0) {
+            return;
+         }
+      }
+
+      std::size_t accs = m_matrix_free ? 0 : (m_length - 1);
+      while (++accs <= m_length) {
+         SearchState state = root_state(accs);
+         add_accumulation(state, accs);
+      }
+   }
+
+   //! Whether the accumulations of the state are the ones of the guide.
+   inline auto is_guided(const SearchState& state) const -> bool {
+      if (state.accumulations != m_guide_accs) {
+         return false;
+      }
+      for (std::size_t op_idx = 0; op_idx < state.accumulations; ++op_idx) {
+         if (!m_guide_accumulations[state.sequence[op_idx].j]) {
+            return false;
+         }
+      }
+      return true;
+   }
+
+   inline auto is_guided(const Operation& op) const -> bool {
+      return std::ranges::any_of(m_guide, [&](const Operation& guide) {
+         return guide.action == op.action && guide.mode == op.mode &&
+                guide.j == op.j && guide.k == op.k && guide.i == op.i;
+      });
+   }
+
+   //! Every elemental that is not accumulated is consumed by exactly one
+   //! elimination: a tangent one costs its tangent cost times the n of a
+   //! Jacobian before it, an adjoint one its adjoint cost times the m of a
+   //! Jacobian after it. The cheapest of these bounds the remaining work.
+   inline auto init_elimination_costs() -> void {
+      const std::vector<Jacobian>& jacs = m_chain.elemental_jacobians;
+      constexpr std::size_t NONE = std::numeric_limits<std::size_t>::max();
+
+      std::vector<std::size_t> min_m(m_length + 1, NONE);
+      for (std::size_t j = m_length; j-- > 0;) {
+         min_m[j] = std::min(min_m[j + 1], jacs[j].m);
+      }
+
+      m_elimination_costs.assign(1, 0);
+      std::size_t min_n = NONE;
+      for (std::size_t e = 0; e < m_length; ++e) {
+         std::size_t cost = NONE;
+         if (min_n != NONE) {
+            cost = jacs[e].tangent_cost * min_n;
+         }
+         if (min_m[e + 1] != NONE && (m_available_memory == 0 ||
+                                      m_available_memory >=
+                                           jacs[e].edges_in_dag)) {
+            cost = std::min(cost, jacs[e].adjoint_cost * min_m[e + 1]);
+         }
+         // Such an elemental can only be accumulated
+         if (cost == NONE) {
+            cost = 0;
+         }
+
+         m_elimination_costs.push_back(m_elimination_costs.back() + cost);
+         min_n = std::min(min_n, jacs[e].n);
+      }
+   }
+
+   //! Elimination costs of the elementals the operation consumes.
+   inline auto consumed_elimination_costs(const Operation& op) const
+        -> std::size_t {
+      std::size_t first = 0;
+      std::size_t last = 0;
+      if (op.action == Action::ACCUMULATION) {
+         first = last = op.j;
+      } else if (op.action == Action::ELIMINATION) {
+         if (op.mode == Mode::TANGENT) {
+            first = op.k + 1;
+            last = op.j;
+         } else {
+            first = op.i;
+            last = op.k;
+         }
+      } else {
+         return 0;
+      }
+      return m_elimination_costs[last + 1] - m_elimination_costs[first];
+   }
+
+   //! Lower bound on the work of every complete sequence below the node.
+   inline auto work_bound(const SearchState& state) const -> std::size_t {
+      if (!m_use_work_bound) {
+         return 0;
+      }
+      return std::max(
+           m_sequential_cost, state.work + state.remaining_eliminations);
+   }
+
+   //! Lower bound on the makespan of a sequence with that critical path and
+   //! work for the thread count of the target.
+   inline static auto lower_bound(
+        const Target& target, const std::size_t critical_path,
+        const std::size_t work) -> std::size_t {
+      if (target.threads == 0) {
+         return critical_path;
+      }
+      return std::max(
+           critical_path, (work + target.threads - 1) / target.threads);
+   }
+
+   //! Whether a sequence with that lower bound can't improve any target.
+   inline auto prunable(const Target& target, const std::size_t lower_bound)
+        const -> bool {
+      return lower_bound >= target.incumbent->makespan() ||
+             lower_bound > target.upper_bound;
+   }
+
+   inline auto prunable(
+        const std::size_t critical_path, const std::size_t work) const
+        -> bool {
+      return std::ranges::all_of(m_targets, [&](const Target& target) {
+         return prunable(target, lower_bound(target, critical_path, work));
+      });
+   }
+
+   //! Publish the schedule to the target and all targets with more threads.
+   inline auto publish(
+        const std::size_t target_idx, const Sequence& sequence,
+        const std::size_t makespan) -> void {
+      if (!m_targets[target_idx].incumbent->update(sequence, makespan)) {
+         return;
+      }
+
+      #pragma omp atomic
+      m_updated_makespan++;
+
+      for (std::size_t t = target_idx + 1; t < m_targets.size(); ++t) {
+         m_targets[t].incumbent->update(sequence, makespan);
+      }
+   }
+
+   //! Whether the search has to stop (the open nodes are kept).
+   inline auto interrupted() -> bool {
+      return !remaining_time() ||
+             m_stop_requested.load(std::memory_order_relaxed);
+   }
+
+   //! Remember a node the search skips, see resume(). The nodes of a
+   //! discrepancy pass are not, as the complete search still follows.
+   inline auto save_open_node(
+        const Sequence& sequence, const std::size_t accumulations,
+        const std::size_t elim_idx) -> void {
+      if (m_discrepancy_limit != UNLIMITED) {
+         return;
+      }
+
+      FrontierNode node {
+           .sequence = sequence,
+           .accumulations = accumulations,
+           .elim_idx = elim_idx};
+      for (Operation& op : node.sequence) {
+         op.thread = 0;
+         op.start_time = 0;
+         op.is_scheduled = false;
+      }
+
+      std::lock_guard<std::mutex> lock(m_open_nodes_mutex);
+      m_open_nodes.push_back(std::move(node));
+   }
+
+   //! Whether the children of a node are spawned as separate tasks.
+   inline auto spawn_tasks(const SearchState& state) const -> bool {
+      const std::size_t depth = state.sequence.length() - state.accumulations;
+      return depth < m_task_depth;
+   }
+
    inline auto add_accumulation(
-        Sequence& sequence, JacobianChain& chain, const std::size_t accs,
-        std::vector<OpPair>& eliminations, std::size_t j = 0) -> void {
+        SearchState& state, const std::size_t accs, std::size_t j = 0)
+        -> void {
       if (accs > 0) {
          for (; j < m_chain.length(); ++j) {
             const Operation op = cheapest_accumulation(j);
-            if (!chain.apply(op)) {
+            if (!push_operation(state, op)) {
                continue;
             }
 
-            push_possible_eliminations(chain, eliminations, op.j, op.i);
-            sequence.push_back(std::move(op));
+            add_accumulation(state, accs - 1, j + 1);
 
-            add_accumulation(sequence, chain, accs - 1, eliminations, j + 1);
-
-            sequence.pop_back();
-            eliminations.pop_back();
-            chain.revert(op);
+            pop_operation(state, op);
+         }
+      } else if (m_guide_accs > 0) {
+         // The guided accumulations were searched first, any other ones
+         // are a discrepancy
+         if (is_guided(state) || state.discrepancies == 0) {
+            return;
          }
+         state.discrepancies--;
+         add_elimination_root(state);
+         state.discrepancies++;
       } else {
-         // Copies for spawned task (Necessary on Windows)
-         Sequence task_sequence = sequence;
-         JacobianChain task_chain = chain;
-         std::vector<OpPair> task_eliminations = eliminations;
+         add_elimination_root(state);
+      }
+   }
+
+   //! Search the eliminations after the accumulations of the state.
+   inline auto add_elimination_root(SearchState& state) -> void {
+      const std::size_t critical_path = std::ranges::max(state.finish_times);
 
-         #pragma omp task default(none) firstprivate(task_sequence)            \
-                          firstprivate(task_chain, task_eliminations)
-         add_elimination(task_sequence, task_chain, task_eliminations);
+      if (spawn_tasks(state)) {
+         // Copy for spawned task (Necessary on Windows)
+         SearchState* task_state = m_state_pool.acquire(state);
+         const util::TaskOrigin origin = util::TaskOrigin::spawn();
+
+         #pragma omp task default(none) firstprivate(task_state)            \
+                          firstprivate(critical_path, origin)
+         {
+            origin.started();
+            add_elimination(*task_state, critical_path);
+            m_state_pool.release(task_state);
+         }
+      } else {
+         add_elimination(state, critical_path);
       }
    }
 
    inline auto add_elimination(
-        Sequence& sequence, JacobianChain& chain,
-        std::vector<OpPair>& eliminations, std::size_t elim_idx = 0) -> void {
+        SearchState& state, const std::size_t critical_path,
+        std::size_t elim_idx = 0) -> void {
 
-      // Return if time's up
-      if (!remaining_time()) {
+      // Return if time's up, the node stays open
+      if (interrupted()) {
+         save_open_node(state.sequence, state.accumulations, elim_idx);
          return;
       }
+      util::count(util::Counter::OPTIMIZER_NODES);
 
-      // Check if we accumulated the entire jacobian
-      if (chain.get_jacobian(chain.length() - 1, 0).is_accumulated) {
-         assert(elim_idx == eliminations.size() - 1);
-         assert(!eliminations[elim_idx][0].has_value());
-         assert(!eliminations[elim_idx][1].has_value());
+      const Sequence& sequence = state.sequence;
+      const JacobianChain& chain = state.chain;
+      const bool spawn = spawn_tasks(state);
 
-         // Start new task for the scheduling of the final sequence. If
-         // branch & bound is used as the scheduling algorithm, this can take
-         // some time.
+      // Check the lower bounds. The critical path is maintained incrementally
+      // via the finish times of the operations (see push_finish_time), the
+      // work via push_operation.
+      assert(critical_path == sequence.critical_path());
+      if (prunable(critical_path, work_bound(state))) {
+         std::size_t& prune_counter = m_pruned_branches[sequence.length()];
 
-         // Copies for spawned task (Necessary on Windows)
-         Sequence final_sequence = sequence;
-         scheduler::Scheduler* scheduler = m_scheduler;
+         #pragma omp atomic
+         prune_counter++;
 
-         #pragma omp task default(shared) \
-                          firstprivate(final_sequence, scheduler)
-         {
-            const double time_to_schedule = remaining_time();
-            if (time_to_schedule) {
-               scheduler->set_timer(time_to_schedule);
+         util::count(util::Counter::PRUNED_SEQUENCE_BOUND);
+         return;
+      }
 
-               const std::size_t new_makespan = scheduler->schedule(
-                    final_sequence, m_usable_threads, m_makespan);
+      // Check if we accumulated the entire jacobian
+      if (chain.is_accumulated(chain.length() - 1, 0)) {
+         assert(elim_idx == state.eliminations.size() - 1);
+         assert(!state.eliminations[elim_idx][0].has_value());
+         assert(!state.eliminations[elim_idx][1].has_value());
 
-               m_timer_expired |= !scheduler->finished_in_time();
+         // Copy, the scheduler overwrites threads and start times
+         Sequence* final_sequence = m_sequence_pool.acquire(sequence);
 
-               #pragma omp atomic
-               m_leafs++;
+         // Start new task for the scheduling of the final sequence if we are
+         // still close to the root. If branch & bound is used as the
+         // scheduling algorithm, this can take some time.
+         if (spawn) {
+            const util::TaskOrigin origin = util::TaskOrigin::spawn();
 
-               #pragma omp critical
-               if (m_makespan > new_makespan) {
-                  m_optimal_sequence = final_sequence;
-                  m_makespan = new_makespan;
-                  m_updated_makespan++;
-               }
+            #pragma omp task default(shared) firstprivate(final_sequence)   \
+                             firstprivate(critical_path, origin)
+            {
+               origin.started();
+               schedule_sequence(*final_sequence, critical_path);
+               m_sequence_pool.release(final_sequence);
             }
+         } else {
+            schedule_sequence(*final_sequence, critical_path);
+            m_sequence_pool.release(final_sequence);
          }
          return;
       }
 
-      // Check critical path as lower bound
-      const std::size_t lower_bound = sequence.critical_path();
-      if (lower_bound >= m_makespan || lower_bound > m_upper_bound) {
-         std::size_t& prune_counter = m_pruned_branches[sequence.length()];
+      // Perform all possible elimination from the current elim_idx. Every
+      // child is visited once either way, only the order changes.
+      const std::size_t begin = state.children.size();
+      push_children(state, critical_path, elim_idx);
+      const std::size_t end = state.children.size();
 
-         #pragma omp atomic
-         prune_counter++;
+      std::size_t visited = 0;
+      for (std::size_t c = begin; c < end; ++c) {
+         const Operation op = state.children[c].op;
+         const std::size_t next_elim_idx = state.children[c].elim_idx + 1;
 
-         return;
+         // Every child but the first is a discrepancy
+         const bool discrepancy = visited > 0;
+         if (discrepancy && state.discrepancies == 0) {
+            break;
+         }
+         if (!push_operation(state, op)) {
+            continue;
+         }
+         visited++;
+         state.discrepancies -= discrepancy;
+
+         const std::size_t next_critical_path = std::max(
+              critical_path, state.finish_times.back());
+
+         if (spawn) {
+            // Copy for spawned task (Necessary on Windows)
+            SearchState* task_state = m_state_pool.acquire(state);
+            task_state->children.clear();
+            const util::TaskOrigin origin = util::TaskOrigin::spawn();
+
+            #pragma omp task default(none) firstprivate(task_state, origin)    \
+                             firstprivate(next_critical_path, next_elim_idx)
+            {
+               origin.started();
+               add_elimination(*task_state, next_critical_path, next_elim_idx);
+               m_state_pool.release(task_state);
+            }
+         } else {
+            add_elimination(state, next_critical_path, next_elim_idx);
+         }
+
+         state.discrepancies += discrepancy;
+         pop_operation(state, op);
       }
+      state.children.resize(begin);
+   }
 
-      // Perform all possible elimination from the current elim_idx
-      for (; elim_idx < eliminations.size(); ++elim_idx) {
+   //! Appends the eliminations from elim_idx on to the children of the
+   //! state, in the order they are visited: guided ones first, then (with
+   //! child_order) by the critical path they lead to and their fma.
+   inline auto push_children(
+        SearchState& state, const std::size_t critical_path,
+        const std::size_t elim_idx) -> void {
+      // Entry idx holds the eliminations operation idx made possible
+      assert(state.eliminations.size() == state.finish_times.size());
+      const std::size_t begin = state.children.size();
+      for (std::size_t idx = elim_idx; idx < state.eliminations.size(); ++idx) {
          for (std::size_t pair_idx = 0; pair_idx <= 1; ++pair_idx) {
-            if (!eliminations[elim_idx][pair_idx].has_value()) {
+            if (!state.eliminations[idx][pair_idx].has_value()) {
                continue;
             }
 
-            const Operation op = eliminations[elim_idx][pair_idx].value();
-            if (!chain.apply(op)) {
-               continue;
-            }
+            // The operation consumes the result of operation idx and an
+            // elemental (exact critical path) or another result (estimate)
+            const Operation& op = state.eliminations[idx][pair_idx].value();
+            state.children.push_back(
+                 {.op = op,
+                  .elim_idx = idx,
+                  .critical_path = std::max(
+                       critical_path, state.finish_times[idx] + op.fma),
+                  .guided = !m_guide.empty() && is_guided(op)});
+         }
+      }
 
-            push_possible_eliminations(chain, eliminations, op.j, op.i);
-            sequence.push_back(op);
+      const auto first = state.children.begin() + begin;
+      if (m_use_child_order) {
+         std::stable_sort(
+              first, state.children.end(),
+              [](const Child& lhs, const Child& rhs) {
+                 if (lhs.guided != rhs.guided) return lhs.guided;
+                 if (lhs.guided) return lhs.elim_idx < rhs.elim_idx;
+                 return std::tuple(lhs.critical_path, lhs.op.fma) <
+                        std::tuple(rhs.critical_path, rhs.op.fma);
+              });
+      } else if (!m_guide.empty()) {
+         std::stable_partition(first, state.children.end(), [](const Child& c) {
+            return c.guided;
+         });
+      }
+   }
 
-            add_elimination(sequence, chain, eliminations, elim_idx + 1);
+   inline auto schedule_sequence(
+        Sequence& sequence, const std::size_t critical_path) -> void {
+      // A leaf that is not (completely) scheduled stays open
+      const auto save_leaf = [&]() {
+         save_open_node(
+              sequence, sequence.count_accumulations(), sequence.length() - 1);
+      };
+
+      const double time_to_schedule = remaining_time();
+      if (!time_to_schedule ||
+          m_stop_requested.load(std::memory_order_relaxed)) {
+         save_leaf();
+         return;
+      }
+
+      // Thread counts the sequence cannot improve are skipped, e.g. in a
+      // sweep once fewer threads reached its critical path
+      const std::size_t work = m_use_work_bound ? sequence.sequential_makespan()
+                                                : 0;
+      bool finished = true;
+      for (std::size_t t = 0; t < m_targets.size(); ++t) {
+         const Target& target = m_targets[t];
+         if (prunable(target, lower_bound(target, critical_path, work))) {
+            continue;
+         }
 
-            sequence.pop_back();
-            eliminations.pop_back();
-            chain.revert(op);
+         // Some schedulers bound with the start times they are given
+         for (Operation& op : sequence) {
+            op.start_time = 0;
+            op.is_scheduled = false;
          }
+         finished &= schedule_sequence(t, sequence, time_to_schedule);
       }
+
+      if (!finished) {
+         save_leaf();
+      }
+   }
+
+   //! Schedule the sequence for one target. Returns false if the scheduler
+   //! ran out of time.
+   inline auto schedule_sequence(
+        const std::size_t target_idx, Sequence& sequence,
+        const double time_to_schedule) -> bool {
+      const Target& target = m_targets[target_idx];
+      Incumbent& incumbent = *target.incumbent;
+
+      // Skip sequences with the same precedence DAG as an already scheduled
+      // one, if that one cannot beat the incumbent.
+      const bool use_cache = m_use_schedule_cache &&
+                             m_scheduler->proves_optimality();
+      scheduler::ScheduleCache::Key key {};
+      if (use_cache) {
+         key = scheduler::ScheduleCache::make_key(sequence, target.threads);
+         const std::optional<scheduler::ScheduleCacheEntry> entry =
+              m_schedule_cache.find(key);
+         if (entry && entry->makespan >= incumbent.makespan()) {
+            #pragma omp atomic
+            m_cache_hits++;
+
+            util::count(util::Counter::PRUNED_SCHEDULE_CACHE);
+            return true;
+         }
+      }
+
+      // The result reaches the incumbent (and thereby the pruning of the
+      // enumeration) once the scheduler completes the sequence. A sweep
+      // schedules synchronously, as it publishes to several incumbents.
+      if (m_scheduler->is_asynchronous() && m_targets.size() == 1) {
+         m_scheduler->submit(sequence, target.threads, incumbent);
+
+         #pragma omp atomic
+         m_leafs++;
+
+         return true;
+      }
+
+      m_scheduler->set_timer(time_to_schedule);
+      const std::size_t upper_bound = incumbent.makespan();
+      const std::size_t new_makespan = m_scheduler->schedule(
+           sequence, target.threads, upper_bound, &incumbent);
+
+      const bool finished = m_scheduler->finished_in_time();
+      m_timer_expired |= !finished;
+
+      #pragma omp atomic
+      m_leafs++;
+
+      // A finished schedule either found the optimum or proved that the
+      // optimum is not below the incumbent that was used for pruning.
+      if (use_cache && finished) {
+         const std::size_t best = incumbent.makespan();
+         m_schedule_cache.insert(
+              key, {.makespan = std::min(new_makespan, best),
+                    .optimal = new_makespan < upper_bound &&
+                               new_makespan <= best});
+      }
+
+      publish(target_idx, sequence, new_makespan);
+      return finished;
+   }
+
+   //! Applies the operation to the chain and appends it to the sequence.
+   //! Returns false (and leaves the state untouched) if that is impossible.
+   inline auto push_operation(SearchState& state, const Operation& op)
+        -> bool {
+      if (!state.chain.apply(op)) {
+         return false;
+      }
+
+      push_possible_eliminations(state.chain, state.eliminations, op.j, op.i);
+      state.sequence.push_back(op);
+      push_finish_time(state.sequence, state.finish_times);
+      state.work += op.fma;
+      state.remaining_eliminations -= consumed_elimination_costs(op);
+      return true;
+   }
+
+   //! Reverts push_operation.
+   inline auto pop_operation(SearchState& state, const Operation& op)
+        -> void {
+      state.remaining_eliminations += consumed_elimination_costs(op);
+      state.work -= op.fma;
+      state.finish_times.pop_back();
+      state.sequence.pop_back();
+      state.eliminations.pop_back();
+      state.chain.revert(op);
+   }
+
+   //! Pushes the finish time of the last operation in the sequence, assuming
+   //! that every operation starts as soon as its operands are available. The
+   //! maximum over all finish times is the critical path of the sequence.
+   inline auto push_finish_time(
+        const Sequence& sequence, std::vector<std::size_t>& finish_times)
+        -> std::size_t {
+      assert(finish_times.size() + 1 == sequence.length());
+      const std::size_t op_idx = sequence.length() - 1;
+
+      std::size_t start_time = sequence[op_idx].start_time;
+      sequence.for_each_child(op_idx, [&](const std::size_t child) {
+         start_time = std::max(start_time, finish_times[child]);
+      });
+
+      finish_times.push_back(start_time + sequence[op_idx].fma);
+      return finish_times.back();
    }
 
    inline auto cheapest_accumulation(const std::size_t j) -> Operation {
-      const Jacobian& jac = m_chain.get_jacobian(j, j);
+      const Jacobian jac = m_chain.get_jacobian(j, j);
       Operation op {
            .action = Action::ACCUMULATION,
            .mode = Mode::TANGENT,
@@ -258,15 +1105,15 @@ class BranchAndBoundOptimizer : public Optimizer, public util::Timer {
       if (op_j < chain.length() - 1) {
          const std::size_t k = op_j;
          const std::size_t i = op_i;
-         const Jacobian& ki_jac = chain.get_jacobian(k, i);
+         const Jacobian ki_jac = chain.get_jacobian(k, i);
 
          // Add multiplication if possible
          std::size_t j;
          for (j = m_chain.length() - 1; j >= k + 1; --j) {
-            const Jacobian& jk_jac = chain.get_jacobian(j, k + 1);
-            if (!jk_jac.is_accumulated || jk_jac.is_used) {
+            if (!chain.is_accumulated(j, k + 1) || chain.is_used(j, k + 1)) {
                continue;
             }
+            const Jacobian jk_jac = chain.get_jacobian(j, k + 1);
 
             ops[0] = Operation {
                  .action = Action::MULTIPLICATION,
@@ -280,7 +1127,7 @@ class BranchAndBoundOptimizer : public Optimizer, public util::Timer {
 
          // Add tangent elimination if multiplication wasn't possible
          if (k + 1 == ++j && m_matrix_free) {
-            const Jacobian& jk_jac = chain.get_jacobian(j, k + 1);
+            const Jacobian jk_jac = chain.get_jacobian(j, k + 1);
             assert(!jk_jac.is_accumulated && !jk_jac.is_used);
 
             ops[0] = Operation {
@@ -297,15 +1144,15 @@ class BranchAndBoundOptimizer : public Optimizer, public util::Timer {
       if (op_i > 0) {
          const std::size_t k = op_i - 1;
          const std::size_t j = op_j;
-         const Jacobian& jk_jac = chain.get_jacobian(j, k + 1);
+         const Jacobian jk_jac = chain.get_jacobian(j, k + 1);
 
          // Add multiplication if possible
          std::size_t i;
          for (i = 0; i <= k; ++i) {
-            const Jacobian& ki_jac = chain.get_jacobian(k, i);
-            if (!ki_jac.is_accumulated || ki_jac.is_used) {
+            if (!chain.is_accumulated(k, i) || chain.is_used(k, i)) {
                continue;
             }
+            const Jacobian ki_jac = chain.get_jacobian(k, i);
 
             ops[1] = Operation {
                  .action = Action::MULTIPLICATION,
@@ -318,7 +1165,7 @@ class BranchAndBoundOptimizer : public Optimizer, public util::Timer {
 
          // Add adjoint elimination if multiplication wasn't possible
          if (k == --i && m_matrix_free) {
-            const Jacobian& ki_jac = chain.get_jacobian(k, i);
+            const Jacobian ki_jac = chain.get_jacobian(k, i);
             assert(!ki_jac.is_accumulated && !ki_jac.is_used);
 
             if (m_available_memory == 0 ||
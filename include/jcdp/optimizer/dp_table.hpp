@@ -0,0 +1,138 @@
+/******************************************************************************
+ * @file jcdp/optimizer/dp_table.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides the table of the
+ *        dynamic programming optimizer.
+ ******************************************************************************/
+
+#ifndef JCDP_OPTIMIZER_DP_TABLE_HPP_
+#define JCDP_OPTIMIZER_DP_TABLE_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "jcdp/operation.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::optimizer {
+
+//! Operation that realizes the cost of a table entry (j and i are implicit).
+struct DPChoice {
+   Action action {Action::NONE};
+   Mode mode {Mode::NONE};
+   std::size_t k {0};
+   std::size_t fma {0};
+};
+
+/******************************************************************************
+ * @brief Dynamic programming table stored as structure of arrays.
+ *
+ * Entries are addressed by the subchain (j, i) and the amount of threads t.
+ * Subchains are stored in triangular order and all thread counts of one
+ * subchain are contiguous (thread-innermost), so the thread split of a
+ * multiplication streams through two short contiguous ranges. Costs and
+ * thread splits, which are read by the recurrence, are kept apart from the
+ * choices that are only needed to reconstruct the sequence.
+ ******************************************************************************/
+class DPTable {
+ public:
+   static constexpr std::size_t MAX_COST =
+        std::numeric_limits<std::size_t>::max();
+
+   //! Reset the table. threads = 0 (unlimited) uses a single slot.
+   inline auto resize(const std::size_t length, const std::size_t threads)
+        -> void {
+      m_threads = std::max<std::size_t>(threads, 1);
+      const std::size_t entries = length * (length + 1) / 2 * m_threads;
+      m_cost.assign(entries, MAX_COST);
+      m_thread_split.assign(entries, 0);
+      m_choice.assign(entries, {});
+   }
+
+   //! Pre-size the table such that resize() doesn't need to reallocate.
+   inline auto reserve(const std::size_t length, const std::size_t threads)
+        -> void {
+      const std::size_t entries = length * (length + 1) / 2 *
+                                  std::max<std::size_t>(threads, 1);
+      m_cost.reserve(entries);
+      m_thread_split.reserve(entries);
+      m_choice.reserve(entries);
+   }
+
+   inline auto threads() const -> std::size_t {
+      return m_threads;
+   }
+
+   //! Costs of subchain (j, i) for 1, ..., threads() threads.
+   inline auto costs(const std::size_t j, const std::size_t i) const
+        -> const std::size_t* {
+      return &m_cost[index(j, i, 1)];
+   }
+
+   inline auto cost(
+        const std::size_t j, const std::size_t i, const std::size_t t) const
+        -> std::size_t {
+      return m_cost[index(j, i, t)];
+   }
+
+   inline auto thread_split(
+        const std::size_t j, const std::size_t i, const std::size_t t) const
+        -> std::size_t {
+      return m_thread_split[index(j, i, t)];
+   }
+
+   inline auto choice(
+        const std::size_t j, const std::size_t i, const std::size_t t) const
+        -> const DPChoice& {
+      return m_choice[index(j, i, t)];
+   }
+
+   inline auto visited(
+        const std::size_t j, const std::size_t i, const std::size_t t) const
+        -> bool {
+      return choice(j, i, t).action != Action::NONE;
+   }
+
+   //! Store the entry if it is cheaper than the current one.
+   inline auto update(
+        const std::size_t j, const std::size_t i, const std::size_t t,
+        const std::size_t cost, const std::size_t thread_split,
+        const DPChoice& choice) -> bool {
+      const std::size_t idx = index(j, i, t);
+      if (cost >= m_cost[idx]) {
+         return false;
+      }
+
+      m_cost[idx] = cost;
+      m_thread_split[idx] = thread_split;
+      m_choice[idx] = choice;
+      return true;
+   }
+
+ private:
+   std::size_t m_threads {1};
+   std::vector<std::size_t> m_cost {};
+   std::vector<std::size_t> m_thread_split {};
+   std::vector<DPChoice> m_choice {};
+
+   inline auto index(
+        const std::size_t j, const std::size_t i, const std::size_t t) const
+        -> std::size_t {
+      assert(i <= j);
+
+      // With a single slot t is ignored (it may be anything if unlimited)
+      const std::size_t slot = m_threads > 1 ? t - 1 : 0;
+      assert(slot < m_threads);
+      return (j * (j + 1) / 2 + i) * m_threads + slot;
+   }
+};
+
+}  // namespace jcdp::optimizer
+
+#endif  // JCDP_OPTIMIZER_DP_TABLE_HPP_
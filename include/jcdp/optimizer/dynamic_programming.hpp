@@ -15,7 +15,6 @@
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
-#include <limits>
 #include <optional>
 #include <print>
 #include <utility>
@@ -24,77 +23,76 @@
 #include "jcdp/jacobian.hpp"
 #include "jcdp/jacobian_chain.hpp"
 #include "jcdp/operation.hpp"
+#include "jcdp/optimizer/dp_table.hpp"
 #include "jcdp/optimizer/optimizer.hpp"
 #include "jcdp/sequence.hpp"
+#include "jcdp/util/instrumentation.hpp"
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
 namespace jcdp::optimizer {
 
-struct DPNode {
-   Operation op {};
-   std::size_t cost {std::numeric_limits<std::size_t>::max()};
-   std::size_t thread_split {0};
-   bool visited {false};
-};
-
 class DynamicProgrammingOptimizer : public Optimizer {
  public:
-   DynamicProgrammingOptimizer() = default;
+   DynamicProgrammingOptimizer() : Optimizer() {
+      register_property(
+           m_tile_size, "dp_tile_size",
+           "Edge length of the tiles of subchains that are solved by one "
+           "thread of the dynamic programming optimizer.");
+      register_property(
+           m_use_tasks, "dp_tasks",
+           "Solve the tiles of the dynamic programming optimizer as OpenMP "
+           "tasks with dependencies instead of one tile diagonal at a time.");
+   }
 
    virtual auto init(const JacobianChain& chain) -> void override final {
       Optimizer::init(chain);
+      m_dptable.resize(m_length, m_usable_threads);
+   }
 
-      std::size_t dp_nodes = m_length * (m_length + 1) / 2;
-      if (m_usable_threads > 0) {
-         dp_nodes *= m_usable_threads;
-
-         // Correct for preaccumulation nodes which only ever use one thread
-         dp_nodes -= (m_usable_threads - 1) * m_length;
-      }
+   virtual auto reserve(const std::size_t max_length) -> void override final {
+      Optimizer::reserve(max_length);
 
-      m_dptable.clear();
-      m_dptable.resize(dp_nodes);
+      // We never use more threads than there are Jacobians
+      m_dptable.reserve(max_length, max_length);
    }
 
    virtual auto solve() -> Sequence override final {
+      const util::ScopedPhase phase("dp_solve");
+
+      // m_usable_threads may have been changed since init()
+      m_dptable.resize(m_length, m_usable_threads);
+
       const std::ptrdiff_t j_max = static_cast<std::ptrdiff_t>(m_length);
+      const std::size_t tile_size = std::max<std::size_t>(m_tile_size, 1);
+      const std::size_t tiles = (m_length + tile_size - 1) / tile_size;
 
-      // Accumulation costs
-      #pragma omp parallel for
-      for (std::ptrdiff_t j = 0; j < j_max; ++j) {
-         try_accumulation<Mode::TANGENT>(j);
-         try_accumulation<Mode::ADJOINT>(j);
-      }
+      #pragma omp parallel default(shared)
+      {
+         // Accumulation costs
+         #pragma omp for
+         for (std::ptrdiff_t j = 0; j < j_max; ++j) {
+            try_accumulation<Mode::TANGENT>(j);
+            try_accumulation<Mode::ADJOINT>(j);
+         }
 
-      // Iterate over amount of available threads. m_usable_threads can be 0
-      // which means unlimited threads, therefore using do-while loop here.
-      std::size_t threads = 1;
-      do {
-         for (std::size_t len = 2; len <= m_length; ++len) {
-            // Chains with same lengths and threads are independent!
-            #pragma omp parallel for
-            for (std::ptrdiff_t j = len - 1; j < j_max; ++j) {
-               const std::ptrdiff_t i = j - (len - 1);
-
-               for (std::ptrdiff_t k = i; k < j; k++) {
-                  try_multiplication(j, i, k, threads);
-
-                  if (m_matrix_free) {
-                     try_elimination<Mode::TANGENT>(j, i, k, threads);
-
-                     // Search for adjoint elimination from the back to the
-                     // to get the longest adjoint elimination chain possible.
-                     // Otherwise we get a lot of single adjoint eliminations
-                     // one after another. Doesn't affect fma, just reduces work
-                     // and makes output smaller.
-                     const std::size_t k2 = j - (k - i + 1);
-                     try_elimination<Mode::ADJOINT>(j, i, k2, threads);
-                  }
+         // Subchain (j, i) depends on (j, k + 1) and (k, i) for i <= k < j.
+         // Tile (J, I) therefore only depends on tiles (J, I') with I' > I
+         // and (J', I) with J' < J, which lie on lower tile diagonals. Tiles
+         // on the same diagonal are independent!
+         if (m_use_tasks) {
+            #pragma omp single
+            solve_tiles_as_tasks(tiles, tile_size);
+         } else {
+            const std::ptrdiff_t d_max = static_cast<std::ptrdiff_t>(tiles);
+            for (std::ptrdiff_t d = 0; d < d_max; ++d) {
+               #pragma omp for schedule(dynamic)
+               for (std::ptrdiff_t tile_i = 0; tile_i < d_max - d; ++tile_i) {
+                  solve_tile(tile_i + d, tile_i, tile_size);
                }
             }
          }
-      } while (++threads <= m_usable_threads);
+      }
 
       return get_sequence();
    }
@@ -107,68 +105,86 @@ class DynamicProgrammingOptimizer : public Optimizer {
       return seq;
    }
 
+   //! Smallest sum of the fma of any sequence for the chain, i.e. the cost
+   //! for a single thread, as of the last solve(). Other optimizers, e.g.
+   //! BranchAndBoundOptimizer::set_sequential_cost(), can use it as a lower
+   //! bound on the work. 0 if there is no thread limit.
+   inline auto sequential_cost() const -> std::size_t {
+      if (m_usable_threads == 0 || m_length == 0) {
+         return 0;
+      }
+      return m_dptable.cost(m_length - 1, 0, 1);
+   }
+
    auto build_sequence(
         const std::size_t j, const std::size_t i,
         const std::pair<std::size_t, std::size_t> thread_pool, Sequence& seq,
         std::size_t start_time = 0) -> std::size_t {
 
       const std::size_t t = thread_pool.second - thread_pool.first + 1;
-      DPNode& fma_ji = node(j, i, t);
-      assert(fma_ji.visited);
-
-      switch (fma_ji.op.action) {
+      assert(m_dptable.visited(j, i, t));
+      const DPChoice& choice = m_dptable.choice(j, i, t);
+      const std::size_t thread_split = m_dptable.thread_split(j, i, t);
+
+      Operation op {
+           .action = choice.action,
+           .mode = choice.mode,
+           .j = j,
+           .k = choice.k,
+           .i = i,
+           .fma = choice.fma};
+
+      switch (op.action) {
          case Action::ACCUMULATION: {
-            fma_ji.op.thread = thread_pool.first;
+            op.thread = thread_pool.first;
             if (m_usable_threads > 0) {
-               fma_ji.op.start_time = std::max(
-                    seq.makespan(fma_ji.op.thread), start_time);
+               op.start_time = std::max(seq.makespan(op.thread), start_time);
             } else {
-               fma_ji.op.start_time = 0;
+               op.start_time = 0;
             }
          } break;
 
          case Action::MULTIPLICATION: {
             std::pair<std::size_t, std::size_t> thread_pool_jk = thread_pool;
             std::pair<std::size_t, std::size_t> thread_pool_ki = thread_pool;
-            if (fma_ji.thread_split > 0) {
-               thread_pool_ki.first = thread_pool.first + fma_ji.thread_split;
+            if (thread_split > 0) {
+               thread_pool_ki.first = thread_pool.first + thread_split;
                thread_pool_jk.second = thread_pool_ki.first - 1;
             }
             const std::size_t jk_end_time = build_sequence(
-                 j, fma_ji.op.k + 1, thread_pool_jk, seq, start_time);
+                 j, op.k + 1, thread_pool_jk, seq, start_time);
 
-            // fma_ji.thread_split == 0 means we perform fma_jk and fma_ki in
-            // serial. Therefore update the start time for fma_ki. This can lead
-            // to a suboptimal schdule and we should reschedule the sequence
-            // with branch & bound as a post-processing step!
-            if (fma_ji.thread_split == 0) {
+            // thread_split == 0 means we perform fma_jk and fma_ki in serial.
+            // Therefore update the start time for fma_ki. This can lead to a
+            // suboptimal schdule and we should reschedule the sequence with
+            // branch & bound as a post-processing step!
+            if (thread_split == 0) {
                start_time = jk_end_time;
             }
 
             const std::size_t ki_end_time = build_sequence(
-                 fma_ji.op.k, i, thread_pool_ki, seq, start_time);
+                 op.k, i, thread_pool_ki, seq, start_time);
 
             if (jk_end_time >= ki_end_time) {
-               fma_ji.op.thread = thread_pool_jk.first;
-               fma_ji.op.start_time = jk_end_time;
+               op.thread = thread_pool_jk.first;
+               op.start_time = jk_end_time;
             } else {
-               fma_ji.op.thread = thread_pool_ki.first;
-               fma_ji.op.start_time = ki_end_time;
+               op.thread = thread_pool_ki.first;
+               op.start_time = ki_end_time;
             }
          } break;
 
          case Action::ELIMINATION: {
             std::size_t end_time;
-            if (fma_ji.op.mode == Mode::TANGENT) {
-               end_time = build_sequence(
-                    fma_ji.op.k, i, thread_pool, seq, start_time);
+            if (op.mode == Mode::TANGENT) {
+               end_time = build_sequence(op.k, i, thread_pool, seq, start_time);
             } else {
                end_time = build_sequence(
-                    j, fma_ji.op.k + 1, thread_pool, seq, start_time);
+                    j, op.k + 1, thread_pool, seq, start_time);
             }
 
-            fma_ji.op.thread = thread_pool.first;
-            fma_ji.op.start_time = end_time;
+            op.thread = thread_pool.first;
+            op.start_time = end_time;
          } break;
 
          default: {
@@ -176,35 +192,79 @@ class DynamicProgrammingOptimizer : public Optimizer {
          }
       }
 
-      fma_ji.op.is_scheduled = true;
-      seq += fma_ji.op;
+      op.is_scheduled = true;
+      seq += op;
       return seq.back().start_time + seq.back().fma;
    }
 
  private:
-   std::vector<DPNode> m_dptable;
+   DPTable m_dptable {};
+   std::size_t m_tile_size {8};
+   bool m_use_tasks {false};
+
+   //! Spawns one task per tile that starts as soon as the tiles it depends on
+   //! are solved. Waiting for (J, I + 1) and (J - 1, I) is sufficient, all
+   //! other dependencies follow transitively.
+   auto solve_tiles_as_tasks(
+        const std::size_t tiles, const std::size_t tile_size) -> void {
+      // The last slot is never written and stands in for "no dependency"
+      std::vector<char> solved(tiles * tiles + 1, 0);
+      char* const none = &solved.back();
+
+      for (std::size_t tile_j = 0; tile_j < tiles; ++tile_j) {
+         for (std::size_t tile_i = tile_j + 1; tile_i-- > 0;) {
+            const bool diagonal = tile_i == tile_j;
+            char* const jk = diagonal ? none
+                                      : &solved[tile_j * tiles + tile_i + 1];
+            char* const ki = diagonal ? none
+                                      : &solved[(tile_j - 1) * tiles + tile_i];
+            char* const ji = &solved[tile_j * tiles + tile_i];
+
+            #pragma omp task default(shared) firstprivate(tile_j, tile_i)      \
+                             depend(in: *jk, *ki) depend(out: *ji)
+            solve_tile(tile_j, tile_i, tile_size);
+         }
+      }
+
+      #pragma omp taskwait
+   }
+
+   //! Subchains of a tile are visited with i descending and j ascending, so
+   //! (j, k + 1) and (k, i) are always solved before (j, i).
+   auto solve_tile(
+        const std::size_t tile_j, const std::size_t tile_i,
+        const std::size_t tile_size) -> void {
+      const std::size_t j_begin = tile_j * tile_size;
+      const std::size_t j_end = std::min(j_begin + tile_size, m_length);
+      const std::size_t i_begin = tile_i * tile_size;
+      const std::size_t i_end = std::min(i_begin + tile_size, m_length);
+
+      for (std::size_t i = i_end; i-- > i_begin;) {
+         for (std::size_t j = std::max(j_begin, i + 1); j < j_end; ++j) {
+            solve_subchain(j, i);
+         }
+      }
+   }
 
-   auto node(const std::size_t j, const std::size_t i, const std::size_t t)
-        -> DPNode& {
-      assert(j < m_length);
-      assert(i < m_length && i <= j);
+   auto solve_subchain(const std::size_t j, const std::size_t i) -> void {
+      for (std::size_t k = i; k < j; k++) {
+         try_multiplication(j, i, k);
 
-      std::size_t idx = j * (j + 1) / 2 + i;
-      if (m_usable_threads > 0 && j != i) {
-         assert(t <= m_usable_threads);
-         idx += (t - 1) * (m_length + 1) * (m_length) / 2;
+         if (m_matrix_free) {
+            try_elimination<Mode::TANGENT>(j, i, k);
 
-         // Correct for preaccumulation nodes which only ever use one thread
-         if (t >= 2) {
-            idx -= (t - 2) * m_length + j;
+            // Search for adjoint elimination from the back to the to get the
+            // longest adjoint elimination chain possible. Otherwise we get a
+            // lot of single adjoint eliminations one after another. Doesn't
+            // affect fma, just reduces work and makes output smaller.
+            const std::size_t k2 = j - (k - i + 1);
+            try_elimination<Mode::ADJOINT>(j, i, k2);
          }
       }
-      return m_dptable[idx];
    }
 
    template<Mode mode>
    auto try_accumulation(const std::size_t j) -> void {
-      std::size_t fma;
       if constexpr (mode == Mode::ADJOINT) {
          if (m_available_memory > 0) {
             const std::size_t mem = m_chain.get_jacobian(j, j).edges_in_dag;
@@ -214,84 +274,63 @@ class DynamicProgrammingOptimizer : public Optimizer {
          }
       }
 
-      fma = m_chain.get_jacobian(j, j).fma<mode>();
-      DPNode& fma_ji = node(j, j, 1);
-      if (fma < fma_ji.cost) {
-         fma_ji.op.action = Action::ACCUMULATION;
-         fma_ji.op.mode = mode;
-         fma_ji.op.fma = fma;
-         fma_ji.op.i = j;
-         fma_ji.op.j = j;
-         fma_ji.op.k = j;
-         fma_ji.cost = fma;
-         fma_ji.thread_split = 0;
-         fma_ji.visited = true;
+      // Preaccumulations only ever use one thread, but are stored for all
+      // thread counts so that the thread splits can read them contiguously.
+      const std::size_t fma = m_chain.get_jacobian(j, j).fma<mode>();
+      const DPChoice choice {
+           .action = Action::ACCUMULATION, .mode = mode, .k = j, .fma = fma};
+      for (std::size_t t = 1; t <= m_dptable.threads(); ++t) {
+         m_dptable.update(j, j, t, fma, 0, choice);
       }
    }
 
    auto try_multiplication(
-        const std::size_t j, const std::size_t i, const std::size_t k,
-        const std::size_t t) -> void {
-      std::size_t cost = std::numeric_limits<std::size_t>::max();
-      std::size_t thread_split = 0;
+        const std::size_t j, const std::size_t i, const std::size_t k)
+        -> void {
+      const std::size_t* costs_jk = m_dptable.costs(j, k + 1);
+      const std::size_t* costs_ki = m_dptable.costs(k, i);
 
-      // Perform fma_jk and fma_ki in serial
-      {
-         const DPNode& fma_jk = node(j, k + 1, t);
-         const DPNode& fma_ki = node(k, i, t);
-         assert(fma_jk.visited);
-         assert(fma_ki.visited);
+      // Dense
+      const std::size_t fma = m_chain.elemental_jacobians[j].m *
+                              m_chain.elemental_jacobians[k].m *
+                              m_chain.elemental_jacobians[i].n;
+      const DPChoice choice {
+           .action = Action::MULTIPLICATION, .mode = Mode::NONE, .k = k,
+           .fma = fma};
 
+      for (std::size_t t = 1; t <= m_dptable.threads(); ++t) {
+         assert(m_dptable.visited(j, k + 1, t));
+         assert(m_dptable.visited(k, i, t));
+         std::size_t cost;
+         std::size_t thread_split = 0;
+
+         // Perform fma_jk and fma_ki in serial
          if (m_usable_threads > 0) {
-            cost = fma_jk.cost + fma_ki.cost;
+            cost = costs_jk[t - 1] + costs_ki[t - 1];
          } else {
-            cost = std::max(fma_jk.cost, fma_ki.cost);
+            cost = std::max(costs_jk[0], costs_ki[0]);
          }
-      }
 
-      // Perform fma_jk and fma_ki in prallel
-      if (t > 1) {
+         // Perform fma_jk and fma_ki in prallel
          for (std::size_t t1 = 1; t1 < t; ++t1) {
             const std::size_t t2 = t - t1;
-            const DPNode& fma_jk = node(j, k + 1, t1);
-            const DPNode& fma_ki = node(k, i, t2);
-            assert(fma_jk.visited);
-            assert(fma_ki.visited);
-
-            const std::size_t c = std::max(fma_jk.cost, fma_ki.cost);
+            const std::size_t c = std::max(costs_jk[t1 - 1], costs_ki[t2 - 1]);
             if (c < cost) {
                cost = c;
                thread_split = t1;
             }
          }
-      }
 
-      // Dense
-      const std::size_t fma = m_chain.elemental_jacobians[j].m *
-                              m_chain.elemental_jacobians[k].m *
-                              m_chain.elemental_jacobians[i].n;
-      cost += fma;
-
-      DPNode& fma_ji = node(j, i, t);
-      if (cost < fma_ji.cost) {
-         fma_ji.op.action = Action::MULTIPLICATION;
-         fma_ji.op.mode = Mode::NONE;
-         fma_ji.op.fma = fma;
-         fma_ji.op.i = i;
-         fma_ji.op.j = j;
-         fma_ji.op.k = k;
-         fma_ji.cost = cost;
-         fma_ji.thread_split = thread_split;
-         fma_ji.visited = true;
+         m_dptable.update(j, i, t, cost + fma, thread_split, choice);
       }
    }
 
    template<Mode mode>
    auto try_elimination(
-        const std::size_t j, const std::size_t i, const std::size_t k,
-        const std::size_t t) -> void {
-      std::size_t cost;
+        const std::size_t j, const std::size_t i, const std::size_t k)
+        -> void {
       std::size_t fma;
+      const std::size_t* costs;
       if constexpr (mode == Mode::ADJOINT) {
          if (m_available_memory > 0) {
             const std::size_t mem = m_chain.get_jacobian(k, i).edges_in_dag;
@@ -300,32 +339,22 @@ class DynamicProgrammingOptimizer : public Optimizer {
             }
          }
 
-         const DPNode& fma_jk = node(j, k + 1, t);
-         assert(fma_jk.visited);
-
          fma = m_chain.get_jacobian(k, i).fma<mode>(
               m_chain.elemental_jacobians[j].m);
-         cost = fma_jk.cost + fma;
+         costs = m_dptable.costs(j, k + 1);
       } else {
-         const DPNode& fma_ki = node(k, i, t);
-         assert(fma_ki.visited);
-
          fma = m_chain.get_jacobian(j, k + 1).fma<mode>(
               m_chain.elemental_jacobians[i].n);
-         cost = fma_ki.cost + fma;
+         costs = m_dptable.costs(k, i);
       }
 
-      DPNode& fma_ji = node(j, i, t);
-      if (cost < fma_ji.cost) {
-         fma_ji.op.action = Action::ELIMINATION;
-         fma_ji.op.mode = mode;
-         fma_ji.op.fma = fma;
-         fma_ji.op.i = i;
-         fma_ji.op.j = j;
-         fma_ji.op.k = k;
-         fma_ji.cost = cost;
-         fma_ji.thread_split = 1;
-         fma_ji.visited = true;
+      const DPChoice choice {
+           .action = Action::ELIMINATION, .mode = mode, .k = k, .fma = fma};
+      for (std::size_t t = 1; t <= m_dptable.threads(); ++t) {
+         assert(
+              mode == Mode::ADJOINT ? m_dptable.visited(j, k + 1, t)
+                                    : m_dptable.visited(k, i, t));
+         m_dptable.update(j, i, t, costs[t - 1] + fma, 1, choice);
       }
    }
 };
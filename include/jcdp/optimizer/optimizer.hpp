@@ -59,6 +59,13 @@ class Optimizer : public util::Properties {
       m_chain.optimized_costs.resize(1 + m_usable_threads);
    }
 
+   //! Pre-size the buffers for chains of up to max_length Jacobians, such
+   //! that repeated calls of init() don't need to reallocate.
+   virtual auto reserve(const std::size_t max_length) -> void {
+      m_chain.reserve(max_length);
+      m_chain.optimized_costs.reserve(1 + max_length);
+   }
+
    virtual auto solve() -> Sequence = 0;
 
    std::size_t m_usable_threads {0};
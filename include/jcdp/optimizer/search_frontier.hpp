@@ -0,0 +1,138 @@
+/******************************************************************************
+ * @file jcdp/optimizer/search_frontier.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides the open nodes of
+ *        an interrupted branch & bound search, so that a later call can
+ *        resume it, and their (text) serialization.
+ ******************************************************************************/
+
+#ifndef JCDP_OPTIMIZER_SEARCH_FRONTIER_HPP_
+#define JCDP_OPTIMIZER_SEARCH_FRONTIER_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <cstddef>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "jcdp/operation.hpp"
+#include "jcdp/sequence.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::optimizer {
+
+/******************************************************************************
+ * @brief Root of a subtree the search did not visit (yet).
+ *
+ * A node is fully described by the operations from the root of the search,
+ * replaying them on the chain restores everything else. elim_idx is the
+ * first elimination the node may still branch on. A complete sequence is a
+ * leaf whose schedule is missing.
+ ******************************************************************************/
+struct FrontierNode {
+   Sequence sequence {};
+   std::size_t accumulations {0};
+   std::size_t elim_idx {0};
+};
+
+/******************************************************************************
+ * @brief Everything needed to resume a search on the same chain.
+ ******************************************************************************/
+struct SearchFrontier {
+   std::vector<FrontierNode> nodes {};
+   //! Best solution at the time of the interruption (empty if none)
+   Sequence incumbent {};
+   std::size_t makespan {std::numeric_limits<std::size_t>::max()};
+
+   inline auto empty() const -> bool {
+      return nodes.empty();
+   }
+};
+
+namespace detail {
+
+inline auto write_sequence(std::ostream& out, const Sequence& sequence)
+     -> void {
+   std::println(out, "{}", sequence.length());
+   for (const Operation& op : sequence) {
+      std::println(
+           out, "{} {} {} {} {} {} {} {} {}", static_cast<int>(op.action),
+           static_cast<int>(op.mode), op.j, op.k, op.i, op.fma, op.thread,
+           op.start_time, static_cast<int>(op.is_scheduled));
+   }
+}
+
+inline auto read_sequence(std::istream& in) -> Sequence {
+   std::size_t length = 0;
+   in >> length;
+
+   Sequence sequence;
+   for (std::size_t i = 0; in && i < length; ++i) {
+      int action = 0;
+      int mode = 0;
+      int is_scheduled = 0;
+      Operation op {};
+      in >> action >> mode >> op.j >> op.k >> op.i >> op.fma >> op.thread >>
+           op.start_time >> is_scheduled;
+      op.action = static_cast<Action>(action);
+      op.mode = static_cast<Mode>(mode);
+      op.is_scheduled = is_scheduled != 0;
+      sequence.push_back(op);
+   }
+   return sequence;
+}
+
+}  // end namespace detail
+
+inline constexpr const char* FRONTIER_HEADER = "jcdp_frontier";
+inline constexpr int FRONTIER_VERSION = 1;
+
+inline auto write_frontier(std::ostream& out, const SearchFrontier& frontier)
+     -> void {
+   std::println(out, "{} {}", FRONTIER_HEADER, FRONTIER_VERSION);
+   std::println(out, "{}", frontier.makespan);
+   detail::write_sequence(out, frontier.incumbent);
+   std::println(out, "{}", frontier.nodes.size());
+   for (const FrontierNode& node : frontier.nodes) {
+      std::println(out, "{} {}", node.accumulations, node.elim_idx);
+      detail::write_sequence(out, node.sequence);
+   }
+}
+
+inline auto read_frontier(std::istream& in) -> SearchFrontier {
+   std::string header;
+   int version = 0;
+   in >> header >> version;
+   if (header != FRONTIER_HEADER || version != FRONTIER_VERSION) {
+      throw std::runtime_error("Not a search frontier (version 1)");
+   }
+
+   SearchFrontier frontier;
+   in >> frontier.makespan;
+   frontier.incumbent = detail::read_sequence(in);
+
+   std::size_t nodes = 0;
+   in >> nodes;
+   for (std::size_t n = 0; in && n < nodes; ++n) {
+      FrontierNode& node = frontier.nodes.emplace_back();
+      in >> node.accumulations >> node.elim_idx;
+      node.sequence = detail::read_sequence(in);
+   }
+
+   if (!in) {
+      throw std::runtime_error("Truncated search frontier");
+   }
+   return frontier;
+}
+
+}  // end namespace jcdp::optimizer
+
+// >>>>>>>>>>>>>>>> INCLUDE TEMPLATE AND INLINE DEFINITIONS <<<<<<<<<<<<<<<<< //
+
+#endif  // JCDP_OPTIMIZER_SEARCH_FRONTIER_HPP_
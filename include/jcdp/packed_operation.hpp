@@ -0,0 +1,106 @@
+/******************************************************************************
+ * @file jcdp/packed_operation.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides a compact
+ *        representation of an operation for the search and scheduling
+ *        kernels, in particular the ones that are offloaded to the GPU.
+ ******************************************************************************/
+
+#ifndef JCDP_PACKED_OPERATION_HPP_
+#define JCDP_PACKED_OPERATION_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <limits>
+
+#include "jcdp/operation.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp {
+
+//! Largest index (or thread id) a PackedOperation can hold. Not a static
+//! member, as those would make PackedOperation unmappable for offloading.
+inline constexpr std::size_t MAX_PACKED_INDEX =
+     std::numeric_limits<std::uint16_t>::max();
+
+/******************************************************************************
+ * @brief Operation with 16 bit indices and thread id (32 instead of 64 bytes).
+ *
+ * Costs and start times keep their full width as they are sums of fmas. The
+ * conversion from and to Operation is lossless as long as the indices and the
+ * thread fit into index_t, which is asserted.
+ ******************************************************************************/
+struct PackedOperation {
+   using index_t = std::uint16_t;
+
+   std::size_t fma {0};
+   std::size_t start_time {0};
+   index_t j {0};
+   index_t k {0};
+   index_t i {0};
+   index_t thread {0};
+   Action action {Action::NONE};
+   Mode mode {Mode::NONE};
+   bool is_scheduled {false};
+
+   PackedOperation() = default;
+
+   explicit PackedOperation(const Operation& op)
+      : fma {op.fma}, start_time {op.start_time}, j {narrow(op.j)},
+        k {narrow(op.k)}, i {narrow(op.i)}, thread {narrow(op.thread)},
+        action {op.action}, mode {op.mode}, is_scheduled {op.is_scheduled} {}
+
+   inline auto to_operation() const -> Operation {
+      return Operation {
+           .action = action,
+           .mode = mode,
+           .j = j,
+           .k = k,
+           .i = i,
+           .fma = fma,
+           .thread = thread,
+           .start_time = start_time,
+           .is_scheduled = is_scheduled};
+   }
+
+ private:
+   inline static auto narrow(const std::size_t value) -> index_t {
+      assert(value <= MAX_PACKED_INDEX);
+      return static_cast<index_t>(value);
+   }
+};
+
+static_assert(sizeof(PackedOperation) == 32);
+
+//! Same as operator<(Operation, Operation), i.e. rhs is an operand of lhs.
+//! Branch-free so that loops over all operations of a sequence vectorize.
+inline auto operator<(const PackedOperation& lhs, const PackedOperation& rhs)
+     -> bool {
+   return (lhs.action != Action::ACCUMULATION) &
+          (((lhs.i == rhs.i) & (lhs.k == rhs.j)) |
+           ((lhs.j == rhs.j) & (lhs.k + 1 == rhs.i)));
+}
+
+inline auto operator>(const PackedOperation& lhs, const PackedOperation& rhs)
+     -> bool {
+   return rhs < lhs;
+}
+
+}  // end namespace jcdp
+
+template<>
+struct std::formatter<jcdp::PackedOperation>
+   : public std::formatter<jcdp::Operation> {
+   template<class FmtContext>
+   auto format(const jcdp::PackedOperation& op, FmtContext& ctx) const
+        -> FmtContext::iterator {
+      return std::formatter<jcdp::Operation>::format(op.to_operation(), ctx);
+   }
+};
+
+#endif  // JCDP_PACKED_OPERATION_HPP_
@@ -14,10 +14,12 @@
 #include <algorithm>
 #include <cstddef>
 #include <execution>
+#include <limits>
 #include <print>
 #include <vector>
 
 #include "jcdp/operation.hpp"
+#include "jcdp/scheduler/branch_and_bound_gpu.hpp"
 #include "jcdp/scheduler/scheduler.hpp"
 #include "jcdp/sequence.hpp"
 
@@ -25,188 +27,96 @@
 
 namespace jcdp::scheduler {
 
+class BnBBlockScheduler {//: public util::Timer{
+ public:
+   BnBBlockScheduler() {
+      m_pool.init();
+   }
+   ~BnBBlockScheduler() = default;
 
-// Method is not class member because of a problem when offloading.
-std::size_t lambda_schedule(
-      Sequence& sequence, std::size_t usable_threads,
-      Sequence& working_copy, std::size_t best_makespan,
-      std::size_t thread_loads[], const std::size_t lower_bound,
-      std::size_t sequential_makespan,
-      const std::size_t upper_bound = std::numeric_limits<std::size_t>::max()) {
-
-      std::size_t makespan = 0;
-      std::size_t idling_time = 0;
-
-      if (lower_bound >= upper_bound) {
-         return lower_bound;
-      }
-
-
-      auto schedule_op = [&](auto& schedule_next_op) -> bool {
-         // Problem with clock on gpu
-	       // Return if time's up
-         //if (!remaining_time()) {
-         //   return true;
-         //}
-
-         bool everything_scheduled = true;
-         for (std::size_t op_idx = 0; op_idx < sequence.length(); ++op_idx) {
-
-	       if (working_copy[op_idx].is_scheduled) {
-               continue;
-            }
-
-            everything_scheduled = false;
-
-            if (!working_copy.is_schedulable(op_idx)) {
-               continue;
-            }
-
-            working_copy[op_idx].is_scheduled = true;
-            bool tried_empty_processor = false;
-	          const std::size_t start = working_copy.earliest_start(op_idx);
-
-            for (size_t t = 0; t < usable_threads; t++) {
-               // We only need to check one empty processor (w.l.o.g.)
-               if (thread_loads[t] == 0) {
-                  if (tried_empty_processor) {
-                     break;
-                  }
-                  tried_empty_processor = true;
-               }
-
-               const std::size_t old_start_time =
-                    working_copy[op_idx].start_time;
-               const std::size_t start_time = std::max(thread_loads[t], start);
-               working_copy[op_idx].start_time = start_time;
-
-               const std::size_t old_thread_load = thread_loads[t];
-               thread_loads[t] = start_time + sequence[op_idx].fma;
-
-               const std::size_t old_idling_time = idling_time;
-               idling_time += (start_time - old_thread_load);
-
-               const std::size_t old_makespan = makespan;
-               makespan = std::max(makespan, thread_loads[t]);
-
-               const std::size_t lb = std::max(
-                    ((idling_time + sequential_makespan) / usable_threads),
-                    working_copy.critical_path());
-
-	             if (std::max(lb, makespan) < best_makespan) {
-                  working_copy[op_idx].thread = t;
-
-	                // Problem here with recursive lambda expressions
-                  // Perform branching and exit if lower bound is reached
-                  if (schedule_next_op(schedule_next_op)) {
-                     return true;
-                  }
-               }
+   //! Depth at which the search trees are split into work items for all
+   //! device threads (see BranchAndBoundBatchGPU).
+   inline auto set_split_depth(const std::size_t split_depth) -> void {
+      m_split_depth = split_depth;
+   }
 
-               thread_loads[t] = old_thread_load;
-               idling_time = old_idling_time;
-               makespan = old_makespan;
-               working_copy[op_idx].start_time = old_start_time;
+   //! Distribute the batches over the first devices visible devices
+   //! (0 = all of them), see DevicePool.
+   inline auto set_devices(const std::size_t devices) -> void {
+      m_pool.init(devices);
+   }
 
-            }
+   /*
+    * This is the second attempt of block scheduling.
+    * The sequences are copied into batches of at most batch_size (0 means
+    * all at once) sequences, each of which is scheduled by a single kernel
+    * launch. The batches are dealt round-robin to the devices of the pool,
+    * once every device has a full batch all of them are scheduled at the
+    * same time. The best makespan of such a round is the upper bound of the
+    * next one. Sequences that don't fit into the device buffers are
+    * scheduled on the host. Returns the index of the best sequence (whose
+    * schedule is set) or sequences.size() if none of them beat the upper
+    * bound.
+    */
+   std::size_t schedule_gpu(
+      std::vector<Sequence>& sequences, const std::size_t threads,
+      const std::size_t upper_bound = std::numeric_limits<std::size_t>::max(),
+      const std::size_t batch_size = 0) {
 
-            working_copy[op_idx].is_scheduled = false;
+      std::size_t best_makespan = upper_bound;
+      std::size_t best_index = sequences.size();
+
+      // All at once means one share per device
+      const std::size_t devices = m_pool.size();
+      const std::size_t capacity = batch_size > 0
+           ? batch_size : (sequences.size() + devices - 1) / devices;
+
+      m_pool.clear();
+      m_pool.set_split_depth(m_split_depth);
+      m_batch_indices.assign(devices, {});
+      std::size_t slot = 0;
+
+      const auto schedule_batches = [&]() {
+         const DevicePool::Result result = m_pool.schedule(best_makespan);
+         if (result.slot < devices) {
+            best_makespan = result.makespan;
+            best_index = m_batch_indices[result.slot][result.index];
+            m_pool.batch(result.slot).apply_best(sequences[best_index]);
          }
+         m_pool.clear();
+         for (std::vector<std::size_t>& indices : m_batch_indices) {
+            indices.clear();
+         }
+         slot = 0;
+      };
 
-         if (everything_scheduled) {
+      for (std::size_t i = 0; i < sequences.size(); i++) {
+         const std::size_t usable_threads = Scheduler::usable_threads(
+              sequences[i], threads);
+
+         if (!BranchAndBoundBatchGPU::fits(sequences[i], usable_threads)) {
+            const std::size_t makespan = schedule_impl(
+                 sequences[i], usable_threads, best_makespan);
             if (makespan < best_makespan) {
                best_makespan = makespan;
-               for (size_t i = 0; i < sequence.length(); ++i) {
-                  sequence[i].thread = working_copy[i].thread;
-                  sequence[i].start_time = working_copy[i].start_time;
-                  sequence[i].is_scheduled = true;
-               }
-               if (best_makespan <= lower_bound) {
-                  return true;
-               }
+               best_index = i;
             }
+            continue;
          }
 
-         return false;
-      };
-
-      schedule_op(schedule_op);
-      return best_makespan;
-   }
-
-class BnBBlockScheduler {//: public util::Timer{
- public:
-   BnBBlockScheduler() = default;
-   ~BnBBlockScheduler() = default;
-
-   /*
-    * This is part of the second attempt of block scheduling.
-    * We gather all information of the sequences to call the inner
-    * scheduling.
-    */
-   std::size_t schedule_gpu(
-      std::vector<Sequence>& sequences, const std::size_t threads,
-      const std::size_t upper_bound = std::numeric_limits<std::size_t>::max()) {
-
-      // Prepare data for block scheduling
-      std::vector<std::size_t> vec_usable_threads(sequences.size());
-      std::vector<std::size_t> vec_sequential_makespan(sequences.size());
-      std::vector<Sequence> vec_working_copy(sequences.size());
-      std::vector<std::size_t> vec_best_makespan(sequences.size());
-      std::vector<std::size_t> vec_thread_loads(threads);
-      std::vector<std::size_t> vec_lower_bound(sequences.size());
-      std::vector<std::size_t> results(sequences.size());
-      std::size_t n = sequences.size();
-
-      //#pragma omp target
-      //#pragma omp parallel for
-      for (std::size_t i = 0; i < n; i++) {
-	       std::size_t usable_threads = sequences[i].count_accumulations();
-         if (threads > 0 && threads < usable_threads) {
-            usable_threads = threads;
-         }
-         vec_usable_threads[i] = usable_threads;
-	       vec_sequential_makespan[i] = sequences[i].sequential_makespan();
-         vec_working_copy[i] = sequences[i];
-         vec_best_makespan[i] = upper_bound;
-         //vec_thread_loads[i] = std::vector<std::size_t>(usable_threads, 0);
-
-         for (Operation& op : vec_working_copy[i]) {
-            op.is_scheduled = false;
+         BranchAndBoundBatchGPU& batch = m_pool.batch(slot);
+         batch.push_back(sequences[i], usable_threads);
+         m_batch_indices[slot].push_back(i);
+         if (batch.size() == capacity && ++slot == devices) {
+            schedule_batches();
          }
-
-         vec_lower_bound[i] = vec_working_copy[i].critical_path();
-      }
-      
-      Sequence* seqs = &sequences[0]; 
-      std::size_t* ut = &vec_usable_threads[0]; 
-      std::size_t* sms = &vec_sequential_makespan[0];
-      Sequence* wc = &vec_working_copy[0];
-      std::size_t* bms = &vec_best_makespan[0];
-      std::size_t* lbs = &vec_lower_bound[0];
-      std::size_t* r = &results[0];
-      std::size_t* tl = &vec_thread_loads[0];
-
-      /*
-       * Here we schedule all the sequences at once in the second attempt.
-       */
-      //SKIP WARNING FOR MVP#pragma omp target map(to :seqs[:n], ut[:n], sms[:n], wc[:n], bms[:n], lbs[:n]) map(r[:n], tl[:n])
-      //SKIP WARNING FOR MVP#pragma omp parallel for
-      for (std::size_t i = 0; i < n; i++) {
-         r[i] = lambda_schedule(seqs[i], ut[i],
-            wc[i], bms[i], tl,
-            lbs[i], sms[i], upper_bound);
       }
 
-      int index = 0;
-      std::size_t best = std::numeric_limits<std::size_t>::max();
-      for (std::size_t i = 0; i < n; i++) {
-         if (r[i] < best) {
-            best = r[i];
-            index = i;
-         }
+      if (m_pool.batch(0).size() > 0) {
+         schedule_batches();
       }
-      return index;
+
+      return best_index;
    }
 
    std::size_t schedule(
@@ -330,6 +240,11 @@ class BnBBlockScheduler {//: public util::Timer{
       schedule_op(schedule_op);
       return best_makespan;
    }
+
+ private:
+   DevicePool m_pool {};
+   std::vector<std::vector<std::size_t>> m_batch_indices {};
+   std::size_t m_split_depth {0};
 };
 
 }  // namespace jcdp::scheduler
@@ -12,127 +12,500 @@
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <print>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "jcdp/incumbent.hpp"
 #include "jcdp/operation.hpp"
+#include "jcdp/scheduler/fixed_size_search.hpp"
+#include "jcdp/scheduler/lower_bound.hpp"
+#include "jcdp/scheduler/priority_list.hpp"
 #include "jcdp/scheduler/scheduler.hpp"
+#include "jcdp/scheduler/transposition_table.hpp"
 #include "jcdp/sequence.hpp"
+#include "jcdp/util/instrumentation.hpp"
+#include "jcdp/util/properties.hpp"
+#include "jcdp/workspace.hpp"
+#include "omp.h"
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
 namespace jcdp::scheduler {
 
-class BranchAndBoundScheduler : public Scheduler {
+class BranchAndBoundScheduler : public Scheduler, public util::Properties {
  public:
+   BranchAndBoundScheduler() {
+      register_property(
+           m_lower_bound_name, "scheduler_lower_bound",
+           "Lower bound of the branch & bound scheduler: critical_path, path, "
+           "level, non_overlap or combined (see LowerBound).",
+           [](util::Properties* p) {
+              auto* scheduler = static_cast<BranchAndBoundScheduler*>(p);
+              scheduler->m_lower_bound =
+                   &lower_bound(scheduler->m_lower_bound_name);
+           });
+      register_property(
+           m_list_incumbent, "scheduler_list_incumbent",
+           "Wether the branch & bound scheduler starts from the schedule of "
+           "the priority list scheduler.");
+      register_property(
+           m_table_capacity, "scheduler_transposition_table",
+           "Maximal amount of states the branch & bound scheduler remembers "
+           "per sequence to discard the ones they dominate (0 = disabled).");
+      register_property(
+           m_task_depth, "scheduler_task_depth",
+           "Amount of operations the branch & bound scheduler schedules "
+           "before it searches the subtrees in parallel tasks (0 = serial).");
+      register_property(
+           m_fixed_size, "scheduler_fixed_size",
+           "Wether the serial branch & bound scheduler uses a search that is "
+           "compiled for the amount of threads on short sequences.");
+   }
+
+   //! Use a custom bound instead of the configured one. It has to outlive
+   //! the scheduler.
+   inline auto set_lower_bound(const LowerBound& bound) -> void {
+      m_lower_bound = &bound;
+   }
+
    virtual auto schedule_impl(
         Sequence& sequence, const std::size_t usable_threads,
-        const std::size_t upper_bound) -> std::size_t override final {
+        const std::size_t upper_bound, const Incumbent* incumbent)
+        -> std::size_t override final {
       const std::size_t sequential_makespan = sequence.sequential_makespan();
 
-      Sequence working_copy = sequence;
+      std::optional<Workspace::Local> own_workspace;
+      Workspace::Local& workspace = local_workspace(own_workspace);
+
+      Sequence& working_copy = workspace.sequence;
+      working_copy = sequence;
       std::size_t best_makespan = upper_bound;
 
-      std::vector<std::size_t> thread_loads(usable_threads, 0);
+      std::vector<std::size_t>& thread_loads = workspace.thread_loads;
+      thread_loads.assign(usable_threads, 0);
       std::size_t makespan = 0;
       std::size_t idling_time = 0;
 
       // Reset potential previous schedule
       for (Operation& op : working_copy) {
          op.is_scheduled = false;
+         op.start_time = 0;
       }
 
-      const std::size_t lower_bound = working_copy.critical_path();
+      const LowerBound& bound = *m_lower_bound;
+      bound.prepare(working_copy, workspace);
+      const auto node_bound = [&]() {
+         return bound.bound(
+              {.sequence = working_copy,
+               .thread_loads = thread_loads,
+               .makespan = makespan,
+               .idling_time = idling_time,
+               .sequential_makespan = sequential_makespan},
+              workspace);
+      };
 
+      const std::size_t lower_bound = node_bound();
       if (lower_bound >= upper_bound) {
          return lower_bound;
       }
 
-      auto schedule_op = [&](auto& schedule_next_op) -> bool {
-         // Return if time's up
-         if (!remaining_time()) {
-            return true;
+      // A list schedule is a cheap first incumbent, the search then only
+      // looks for better ones
+      if (m_list_incumbent) {
+         PriorityListScheduler list_scheduler;
+         list_scheduler.set_workspace(workspace_ptr());
+         const std::size_t list_makespan = list_scheduler.schedule_impl(
+              working_copy, usable_threads, best_makespan, nullptr);
+         if (list_makespan < best_makespan) {
+            best_makespan = list_makespan;
+            for (size_t i = 0; i < sequence.length(); ++i) {
+               sequence[i].thread = working_copy[i].thread;
+               sequence[i].start_time = working_copy[i].start_time;
+               sequence[i].is_scheduled = true;
+            }
+            if (best_makespan <= lower_bound) {
+               return best_makespan;
+            }
          }
 
-         bool everything_scheduled = true;
-         for (std::size_t op_idx = 0; op_idx < sequence.length(); ++op_idx) {
-            if (working_copy[op_idx].is_scheduled) {
-               continue;
-            }
-            everything_scheduled = false;
+         thread_loads.assign(usable_threads, 0);
+         for (Operation& op : working_copy) {
+            op.is_scheduled = false;
+            op.start_time = 0;
+         }
+      }
 
-            if (!working_copy.is_schedulable(op_idx)) {
-               continue;
-            }
+      workspace.table.clear(table_capacity(working_copy));
+      const SearchContext context {
+           .bound = bound,
+           .incumbent = incumbent,
+           .usable_threads = usable_threads,
+           .sequential_makespan = sequential_makespan,
+           .lower_bound = lower_bound};
+      NodeState root {};
 
-            working_copy[op_idx].is_scheduled = true;
-            bool tried_empty_processor = false;
-            const std::size_t start = working_copy.earliest_start(op_idx);
+      if (m_task_depth == 0) {
+         if (const FixedSizeKernel kernel = fixed_size_kernel(
+                  working_copy, usable_threads)) {
+            return kernel(
+                 *this, sequence, workspace, incumbent, best_makespan,
+                 lower_bound);
+         }
 
-            for (size_t t = 0; t < usable_threads; t++) {
-               // We only need to check one empty processor (w.l.o.g.)
-               if (thread_loads[t] == 0) {
-                  if (tried_empty_processor) {
-                     break;
-                  }
-                  tried_empty_processor = true;
-               }
+         SerialBest best {.sequence = sequence, .makespan = best_makespan};
+         search(context, workspace, root, best);
+         return best.makespan;
+      }
 
-               const std::size_t old_start_time =
-                    working_copy[op_idx].start_time;
-               const std::size_t start_time = std::max(thread_loads[t], start);
-               working_copy[op_idx].start_time = start_time;
+      // Every task searches on its own copy of the node, as the workspace of
+      // a thread may be taken over by any task it executes meanwhile
+      SharedBest best {.makespan = best_makespan};
+      const auto search_in_tasks = [&]() {
+         #pragma omp taskgroup
+         {
+            spawn(context, workspace, root, best);
+         }
+      };
+      if (omp_in_parallel()) {
+         search_in_tasks();
+      } else {
+         #pragma omp parallel default(shared)
+         #pragma omp single
+         search_in_tasks();
+      }
 
-               const std::size_t old_thread_load = thread_loads[t];
-               thread_loads[t] = start_time + sequence[op_idx].fma;
+      if (best.best.makespan() < best_makespan) {
+         const Sequence best_sequence = best.best.sequence();
+         for (size_t i = 0; i < sequence.length(); ++i) {
+            sequence[i].thread = best_sequence[i].thread;
+            sequence[i].start_time = best_sequence[i].start_time;
+            sequence[i].is_scheduled = true;
+         }
+         best_makespan = best.best.makespan();
+      }
+      return best_makespan;
+   }
 
-               const std::size_t old_idling_time = idling_time;
-               idling_time += (start_time - old_thread_load);
+   virtual auto proves_optimality() const -> bool override final {
+      return true;
+   }
 
-               const std::size_t old_makespan = makespan;
-               makespan = std::max(makespan, thread_loads[t]);
+ private:
+   //! The set of scheduled operations has to fit into the table key.
+   static constexpr std::size_t MAX_TABLE_LENGTH = 64;
 
-               const std::size_t lb = std::max(
-                    ((idling_time + sequential_makespan) / usable_threads),
-                    working_copy.critical_path());
-               if (std::max(lb, makespan) < best_makespan) {
-                  working_copy[op_idx].thread = t;
+   std::string m_lower_bound_name {"combined"};
+   const LowerBound* m_lower_bound {&lower_bound(m_lower_bound_name)};
+   bool m_list_incumbent {true};
+   std::size_t m_table_capacity {1 << 16};
+   std::size_t m_task_depth {0};
+   bool m_fixed_size {true};
 
-                  // Perform branching and exit if lower bound is reached
-                  if (schedule_next_op(schedule_next_op)) {
-                     return true;
-                  }
-               }
+   //! Longest sequences (per kernel) and most threads of the fixed-size
+   //! searches. Every combination is a kernel of its own.
+   static constexpr std::array<std::size_t, 2> FIXED_SIZE_OPS = {16, 32};
+   static constexpr std::size_t FIXED_SIZE_THREADS = 8;
+
+   using FixedSizeKernel = std::size_t (*)(
+        BranchAndBoundScheduler&, Sequence&, Workspace::Local&,
+        const Incumbent*, std::size_t, std::size_t);
+
+   //! Serial search of the working copy of the workspace.
+   template<std::size_t MaxOps, std::size_t Threads>
+   static auto fixed_size_search(
+        BranchAndBoundScheduler& scheduler, Sequence& sequence,
+        Workspace::Local& workspace, const Incumbent* incumbent,
+        const std::size_t best_makespan, const std::size_t lower_bound)
+        -> std::size_t {
+      FixedSizeSearch<MaxOps, Threads, CombinedBound> search(
+           workspace.sequence, scheduler, incumbent, workspace.table,
+           workspace.state);
+      return search.run(sequence, best_makespan, lower_bound);
+   }
+
+   template<std::size_t MaxOps, std::size_t... T>
+   static constexpr auto fixed_size_kernels(std::index_sequence<T...>)
+        -> std::array<FixedSizeKernel, sizeof...(T)> {
+      return {&fixed_size_search<MaxOps, T + 1>...};
+   }
+
+   //! Fixed-size search for the sequence, if there is one. Only the
+   //! combined bound (the default) has fixed-size searches.
+   inline auto fixed_size_kernel(
+        const Sequence& sequence, const std::size_t threads) const
+        -> FixedSizeKernel {
+      static constexpr auto threads_seq = std::make_index_sequence<
+           FIXED_SIZE_THREADS>();
+      static constexpr std::array<
+           std::array<FixedSizeKernel, FIXED_SIZE_THREADS>,
+           FIXED_SIZE_OPS.size()>
+           kernels = {
+                fixed_size_kernels<FIXED_SIZE_OPS[0]>(threads_seq),
+                fixed_size_kernels<FIXED_SIZE_OPS[1]>(threads_seq)};
+
+      if (!m_fixed_size || threads == 0 || threads > FIXED_SIZE_THREADS ||
+          !dynamic_cast<const CombinedBound*>(m_lower_bound)) {
+         return nullptr;
+      }
+      for (std::size_t k = 0; k < FIXED_SIZE_OPS.size(); ++k) {
+         if (sequence.length() <= FIXED_SIZE_OPS[k]) {
+            return kernels[k][threads - 1];
+         }
+      }
+      return nullptr;
+   }
+
+   //! Everything a search needs apart from its node.
+   struct SearchContext {
+      const LowerBound& bound;
+      const Incumbent* incumbent;
+      std::size_t usable_threads {0};
+      std::size_t sequential_makespan {0};
+      std::size_t lower_bound {0};
+   };
+
+   //! Node of the search tree, together with the working copy and the
+   //! thread loads of the workspace it is searched in.
+   struct NodeState {
+      std::size_t makespan {0};
+      std::size_t idling_time {0};
+      //! Set of scheduled operations, the key of the transposition table
+      std::uint64_t scheduled_ops {0};
+      //! Amount of scheduled operations
+      std::size_t depth {0};
+   };
+
+   //! Best schedule of a serial search, written straight into the sequence.
+   struct SerialBest {
+      Sequence& sequence;
+      std::size_t makespan {0};
+
+      inline auto bound(const Incumbent* incumbent) const -> std::size_t {
+         return pruning_bound(makespan, incumbent);
+      }
+
+      inline auto stopped() const -> bool {
+         return false;
+      }
+
+      //! Returns true if the search can stop.
+      inline auto publish(
+           const Sequence& working_copy, const std::size_t new_makespan,
+           const std::size_t lower_bound) -> bool {
+         if (new_makespan >= makespan) {
+            return false;
+         }
+         makespan = new_makespan;
+         for (size_t i = 0; i < sequence.length(); ++i) {
+            sequence[i].thread = working_copy[i].thread;
+            sequence[i].start_time = working_copy[i].start_time;
+            sequence[i].is_scheduled = true;
+         }
+         return makespan <= lower_bound;
+      }
+   };
+
+   //! Best schedule of a parallel search, shared by all of its tasks. They
+   //! all stop once one of them reaches the lower bound.
+   struct SharedBest {
+      //! Makespan before the search (upper bound or list schedule)
+      std::size_t makespan {0};
+      Incumbent best {};
+      std::atomic<bool> done {false};
+
+      inline auto bound(const Incumbent* incumbent) const -> std::size_t {
+         return std::min(makespan, pruning_bound(best.makespan(), incumbent));
+      }
+
+      inline auto stopped() const -> bool {
+         return done.load(std::memory_order_relaxed);
+      }
+
+      inline auto publish(
+           const Sequence& working_copy, const std::size_t new_makespan,
+           const std::size_t lower_bound) -> bool {
+         if (new_makespan < makespan &&
+             best.update(working_copy, new_makespan) &&
+             new_makespan <= lower_bound) {
+            done.store(true, std::memory_order_relaxed);
+         }
+         return stopped();
+      }
+   };
+
+   //! Node of a parallel search that waits for a thread.
+   struct Task {
+      Workspace::Local workspace {};
+      NodeState node {};
+   };
+
+   inline auto table_capacity(const Sequence& sequence) const -> std::size_t {
+      return sequence.length() <= MAX_TABLE_LENGTH ? m_table_capacity : 0;
+   }
+
+   //! Search the node in a new task, on a copy of the parent workspace.
+   inline auto spawn(
+        const SearchContext& context, const Workspace::Local& parent,
+        const NodeState& node, SharedBest& best) -> void {
+      Task* task = new Task {.node = node};
+      task->workspace.sequence = parent.sequence;
+      task->workspace.thread_loads = parent.thread_loads;
+      const util::TaskOrigin origin = util::TaskOrigin::spawn();
+
+      #pragma omp task default(shared) firstprivate(task, origin)
+      {
+         origin.started();
+         if (!best.stopped()) {
+            Workspace::Local& workspace = task->workspace;
+            context.bound.prepare(workspace.sequence, workspace);
+            workspace.table.clear(table_capacity(workspace.sequence));
+            search(context, workspace, task->node, best);
+         }
+         delete task;
+      }
+   }
+
+   //! Depth-first search below the node. In a parallel search, the children
+   //! of nodes above the task depth become tasks of their own. Returns true
+   //! if the search is over.
+   template<typename Best>
+   auto search(
+        const SearchContext& context, Workspace::Local& workspace,
+        NodeState& node, Best& best) -> bool {
+      constexpr bool parallel = std::is_same_v<Best, SharedBest>;
+
+      // Return if time's up or another task reached the lower bound
+      if (!remaining_time() || best.stopped()) {
+         return true;
+      }
+      util::count(util::Counter::SCHEDULER_NODES);
+
+      Sequence& working_copy = workspace.sequence;
+      std::vector<std::size_t>& thread_loads = workspace.thread_loads;
+      const auto node_bound = [&]() {
+         util::count(util::Counter::BOUND_EVALUATIONS);
+         return context.bound.bound(
+              {.sequence = working_copy,
+               .thread_loads = thread_loads,
+               .makespan = node.makespan,
+               .idling_time = node.idling_time,
+               .sequential_makespan = context.sequential_makespan},
+              workspace);
+      };
+
+      const auto op_bit = [](const std::size_t op_idx) -> std::uint64_t {
+         return op_idx < MAX_TABLE_LENGTH ? std::uint64_t {1} << op_idx : 0;
+      };
+
+      // States are identified by the set of scheduled operations. Their
+      // sorted thread loads, the finish times of the scheduled operations
+      // whose parent isn't and the makespan determine all completions.
+      TranspositionTable& table = workspace.table;
+      const auto dominated = [&]() -> bool {
+         if (!table.enabled()) {
+            return false;
+         }
 
-               thread_loads[t] = old_thread_load;
-               idling_time = old_idling_time;
-               makespan = old_makespan;
-               working_copy[op_idx].start_time = old_start_time;
+         std::vector<std::size_t>& state = workspace.state;
+         state.assign(thread_loads.cbegin(), thread_loads.cend());
+         std::ranges::sort(state);
+         for (std::size_t i = 0; i < working_copy.length(); ++i) {
+            const Operation& op = working_copy[i];
+            const std::optional<std::size_t> p = working_copy.parent(i);
+            if (op.is_scheduled && (!p || !working_copy[*p].is_scheduled)) {
+               state.push_back(op.start_time + op.fma);
             }
+         }
+         state.push_back(node.makespan);
+         if (!table.dominated(node.scheduled_ops, state)) {
+            return false;
+         }
+         util::count(util::Counter::PRUNED_DOMINATED);
+         return true;
+      };
 
-            working_copy[op_idx].is_scheduled = false;
+      bool everything_scheduled = true;
+      for (std::size_t op_idx = 0; op_idx < working_copy.length(); ++op_idx) {
+         if (working_copy[op_idx].is_scheduled) {
+            continue;
          }
+         everything_scheduled = false;
 
-         if (everything_scheduled) {
-            if (makespan < best_makespan) {
-               best_makespan = makespan;
-               for (size_t i = 0; i < sequence.length(); ++i) {
-                  sequence[i].thread = working_copy[i].thread;
-                  sequence[i].start_time = working_copy[i].start_time;
-                  sequence[i].is_scheduled = true;
-               }
-               if (best_makespan <= lower_bound) {
+         if (!working_copy.is_schedulable(op_idx)) {
+            continue;
+         }
+
+         working_copy[op_idx].is_scheduled = true;
+         node.scheduled_ops |= op_bit(op_idx);
+         ++node.depth;
+         const std::size_t start = working_copy.earliest_start(op_idx);
+
+         for (size_t t = 0; t < context.usable_threads; t++) {
+            // Threads with the same load are interchangeable, we only
+            // need to check the first one of them (w.l.o.g.)
+            const auto loads_before = thread_loads.cbegin() + t;
+            if (std::find(thread_loads.cbegin(), loads_before,
+                          thread_loads[t]) != loads_before) {
+               continue;
+            }
+
+            const std::size_t old_start_time = working_copy[op_idx].start_time;
+            const std::size_t start_time = std::max(thread_loads[t], start);
+            working_copy[op_idx].start_time = start_time;
+
+            const std::size_t old_thread_load = thread_loads[t];
+            thread_loads[t] = start_time + working_copy[op_idx].fma;
+
+            const std::size_t old_idling_time = node.idling_time;
+            node.idling_time += (start_time - old_thread_load);
+
+            const std::size_t old_makespan = node.makespan;
+            node.makespan = std::max(node.makespan, thread_loads[t]);
+
+            const bool promising = node_bound() < best.bound(
+                 context.incumbent);
+            if (!promising) {
+               util::count(util::Counter::PRUNED_LOWER_BOUND);
+            }
+
+            if (promising && !dominated()) {
+               working_copy[op_idx].thread = t;
+
+               // Perform branching and exit if lower bound is reached
+               if constexpr (parallel) {
+                  if (node.depth <= m_task_depth) {
+                     spawn(context, workspace, node, best);
+                  } else if (search(context, workspace, node, best)) {
+                     return true;
+                  }
+               } else if (search(context, workspace, node, best)) {
                   return true;
                }
             }
+
+            thread_loads[t] = old_thread_load;
+            node.idling_time = old_idling_time;
+            node.makespan = old_makespan;
+            working_copy[op_idx].start_time = old_start_time;
          }
 
-         return false;
-      };
+         working_copy[op_idx].is_scheduled = false;
+         node.scheduled_ops &= ~op_bit(op_idx);
+         --node.depth;
+      }
 
-      schedule_op(schedule_op);
-      return best_makespan;
+      if (everything_scheduled) {
+         return best.publish(working_copy, node.makespan, context.lower_bound);
+      }
+      return false;
    }
 };
 
@@ -2,19 +2,325 @@
 #ifndef JCDP_SCHEDULER_BRANCH_AND_BOUND_GPU_HPP_
 #define JCDP_SCHEDULER_BRANCH_AND_BOUND_GPU_HPP_
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <vector>
 
+#include <omp.h>
+
+#include "jcdp/incumbent.hpp"
+#include "jcdp/packed_operation.hpp"
 #include "jcdp/scheduler/scheduler.hpp"
 #include "jcdp/sequence.hpp"
+#include "jcdp/util/properties.hpp"
 
 namespace jcdp::scheduler {
 
-class BranchAndBoundSchedulerGPU : public Scheduler {
+// Deepest level at which the search trees can be split into work items.
+constexpr std::size_t MAX_SPLIT_DEPTH = 8;
+
+// Best schedule of a batch. index == size() if no sequence beat the bound.
+// finished is false if the search of any sequence ran out of nodes, then the
+// makespan is not proven to be optimal.
+struct BatchScheduleResult {
+  std::size_t makespan;
+  std::size_t index;
+  bool finished{true};
+};
+
+// Subtree of the search of one sequence, given by the decisions (operation
+// and thread) on the path from the root.
+struct WorkItem {
+  std::uint32_t sequence;
+  std::uint32_t depth;
+  PackedOperation::index_t op_idx[MAX_SPLIT_DEPTH];
+  PackedOperation::index_t thread_idx[MAX_SPLIT_DEPTH];
+};
+
+// Sequences that are scheduled by a single kernel launch on the device
+// instead of one offload per sequence. The kernel is compiled for several
+// buffer capacities, the smallest one that fits the longest sequence and the
+// most threads of the batch is used.
+//
+// With split depth 0 every device thread searches one sequence. Otherwise the
+// search trees are split on the host into work items at the split depth. They
+// form a queue in device memory from which all device threads pop items until
+// it is empty, sharing the best makespan of each sequence via atomics.
+class BranchAndBoundBatchGPU {
+ public:
+  // Whether the sequence fits into the largest device buffers.
+  static auto fits(const Sequence& sequence, std::size_t usable_threads)
+      -> bool;
+
+  auto push_back(const Sequence& sequence, std::size_t usable_threads)
+      -> void;
+
+  // Schedule all sequences of the batch. Only the schedule of the best
+  // sequence is transferred back, see apply_best().
+  auto schedule(std::size_t upper_bound) -> BatchScheduleResult;
+
+  // Like schedule(), but returns right after the kernel is enqueued. The
+  // transfers and the kernel are deferred target tasks, ordered by their
+  // dependencies on the batch. on_done is called with the result by the task
+  // that completes the batch, which the caller can wait for with taskwait or
+  // a taskgroup. The batch must not be modified before that.
+  auto schedule_async(
+      std::size_t upper_bound,
+      std::function<void(const BatchScheduleResult&)> on_done) -> void;
+
+  // Copy the schedule of the best sequence of the last schedule() call.
+  auto apply_best(Sequence& sequence) const -> void;
+
+  auto size() const -> std::size_t {
+    return m_usable_threads.size();
+  }
+
+  auto set_split_depth(const std::size_t split_depth) -> void {
+    m_split_depth = split_depth;
+  }
+
+  // Nodes every device thread may visit per schedule() call (see
+  // BranchAndBoundSchedulerGPU::node_budget).
+  auto set_node_budget(const std::size_t node_budget) -> void {
+    m_node_budget = node_budget;
+  }
+
+  // Device the batch is scheduled on by the next schedule() call.
+  auto set_device(const int device) -> void {
+    m_device = device;
+  }
+
+  auto device() const -> int {
+    return m_device;
+  }
+
+  // Allocate the buffers for `sequences` sequences on the device once. The
+  // next schedule() calls only update their contents, a larger batch
+  // allocates them again with twice the capacity. Not for schedule_async().
+  auto make_resident(std::size_t sequences) -> void;
+
+  // Free the device buffers of make_resident().
+  auto release_resident() -> void;
+
+  // Keeps the capacity for the next batch.
+  auto clear() -> void {
+    m_ops.clear();
+    m_offsets.clear();
+    m_usable_threads.clear();
+    m_sequential_makespans.clear();
+    m_max_length = 0;
+    m_max_threads = 0;
+  }
+
+ private:
+  // Operations of all sequences back to back, sequence i is
+  // [m_offsets[i], m_offsets[i + 1]).
+  std::vector<PackedOperation> m_ops{};
+  std::vector<std::size_t> m_offsets{};
+  std::vector<std::size_t> m_usable_threads{};
+  std::vector<std::size_t> m_sequential_makespans{};
+  std::vector<std::size_t> m_makespans{};
+  std::vector<std::uint8_t> m_finished{};
+  std::size_t m_max_length{0};
+  std::size_t m_max_threads{0};
+  std::size_t m_best_index{0};
+  std::size_t m_split_depth{0};
+  std::size_t m_node_budget{std::numeric_limits<std::size_t>::max()};
+  int m_device{omp_get_default_device()};
+
+  // Work queue and the best schedule found per work item
+  std::vector<WorkItem> m_items{};
+  std::vector<std::size_t> m_lower_bounds{};
+  std::vector<std::size_t> m_item_makespans{};
+  std::vector<PackedOperation> m_item_schedules{};
+
+  // Host buffers the device buffers were allocated for, sequences == 0 if
+  // the batch is mapped per launch instead.
+  struct ResidentBuffers {
+    PackedOperation* ops{nullptr};
+    std::size_t* offsets{nullptr};
+    std::size_t* usable_threads{nullptr};
+    std::size_t* sequential_makespans{nullptr};
+    std::size_t* makespans{nullptr};
+    std::uint8_t* finished{nullptr};
+    std::size_t sequences{0};
+    int device{0};
+  };
+  ResidentBuffers m_resident{};
+
+  // Allocate the device buffers again if the batch outgrew them.
+  auto update_resident() -> void;
+
+  auto all_finished() const -> bool {
+    return std::ranges::all_of(m_finished, [](const std::uint8_t f) {
+      return f != 0;
+    });
+  }
+
+  template<std::size_t MaxLength, std::size_t MaxThreads>
+  auto launch(std::size_t upper_bound) -> BatchScheduleResult;
+
+  template<std::size_t MaxLength, std::size_t MaxThreads>
+  auto launch_async(
+      std::size_t upper_bound,
+      std::function<void(const BatchScheduleResult&)> on_done) -> void;
+
+  template<std::size_t MaxLength, std::size_t MaxThreads>
+  auto launch_queue(std::size_t upper_bound) -> BatchScheduleResult;
+};
+
+// Numbers of the devices the scheduling is distributed over: the first
+// `devices` visible ones (0 = all of them). Without any device it is the
+// default device, i.e. the batches run in the host fallback.
+auto pool_devices(std::size_t devices) -> std::vector<int>;
+
+// One batch per device. The batches are filled independently and scheduled
+// concurrently. The buffers of every batch stay allocated on its device for
+// the lifetime of the pool, a launch only transfers their contents.
+class DevicePool {
  public:
+  // Sequences per batch the device buffers are allocated for initially.
+  static constexpr std::size_t RESIDENT_SEQUENCES = 256;
+
+  DevicePool() = default;
+  DevicePool(const DevicePool&) = delete;
+  auto operator=(const DevicePool&) -> DevicePool& = delete;
+  ~DevicePool();
+
+  // Cross-device best: makespan and the device (pool slot) and index within
+  // its batch of the best schedule. slot == size() if none beat the bound.
+  // finished is false if any batch ran out of nodes.
+  struct Result {
+    std::size_t makespan;
+    std::size_t slot;
+    std::size_t index;
+    bool finished{true};
+  };
+
+  // Use the first `devices` visible devices (0 = all) and clear the batches.
+  auto init(std::size_t devices = 0) -> void;
+
+  auto size() const -> std::size_t {
+    return m_batches.size();
+  }
+
+  auto batch(const std::size_t slot) -> BranchAndBoundBatchGPU& {
+    return m_batches[slot];
+  }
+
+  auto set_split_depth(std::size_t split_depth) -> void;
+
+  // Schedule the non-empty batches, one host thread drives each device.
+  // Ties between devices go to the lowest slot.
+  auto schedule(std::size_t upper_bound) -> Result;
+
+  auto clear() -> void;
+
+ private:
+  std::vector<BranchAndBoundBatchGPU> m_batches{};
+};
+
+// Branch & bound scheduler that runs on the device. Sequences that don't fit
+// into the device buffers are scheduled by the host BranchAndBoundScheduler.
+//
+// With a pipeline batch size > 0 the scheduler is asynchronous: submitted
+// sequences are collected in one of two staging batches. A full batch is
+// launched without waiting for it (if the other one isn't still in flight),
+// so that the host keeps enumerating sequences while the device schedules.
+// The results are published to the incumbent when the batch completes.
+// With several devices every full batch goes to a device that is idle, the
+// stage keeps filling while all of them are busy.
+class BranchAndBoundSchedulerGPU : public Scheduler, public util::Properties {
+ public:
+  BranchAndBoundSchedulerGPU() {
+    register_property(
+        m_split_depth, "gpu_split_depth",
+        "Depth at which the GPU scheduler splits the search tree into work "
+        "items for all device threads (0 = one device thread per sequence).");
+    register_property(
+        m_devices, "gpu_devices",
+        "Amount of devices the GPU scheduler distributes batches over "
+        "(0 = all visible devices).");
+    register_property(
+        m_pipeline_batch, "gpu_pipeline_batch",
+        "Amount of sequences the GPU scheduler collects before it launches "
+        "them asynchronously while the search continues (0 = synchronous).");
+    register_property(
+        m_nodes_per_second, "gpu_nodes_per_second",
+        "Search nodes a device thread of the GPU scheduler visits per second, "
+        "converts the time limit into a node budget for the kernels.");
+  }
+
   auto schedule_impl(
       Sequence& sequence,
       std::size_t usable_threads,
-      std::size_t upper_bound) -> std::size_t override final;
+      std::size_t upper_bound,
+      const Incumbent* incumbent) -> std::size_t override final;
+
+  auto is_asynchronous() const -> bool override final {
+    return m_pipeline_batch > 0;
+  }
+
+  auto submit(
+      const Sequence& sequence,
+      std::size_t threads,
+      Incumbent& incumbent) -> void override final;
+
+  auto wait(Incumbent& incumbent) -> void override final;
+
+  auto set_split_depth(const std::size_t split_depth) -> void {
+    m_split_depth = split_depth;
+  }
+
+  auto set_pipeline_batch(const std::size_t pipeline_batch) -> void {
+    m_pipeline_batch = pipeline_batch;
+  }
+
+  // Takes effect with the next submitted sequence after wait().
+  auto set_devices(const std::size_t devices) -> void {
+    m_devices = devices;
+  }
+
+ private:
+  // Staging batch, the host copies of its sequences and the pool slot of
+  // the device it is in flight on.
+  struct Stage {
+    BranchAndBoundBatchGPU batch{};
+    std::vector<Sequence> sequences{};
+    bool in_flight{false};
+    std::size_t slot{0};
+  };
+
+  std::size_t m_split_depth{0};
+  std::size_t m_pipeline_batch{0};
+  std::size_t m_devices{0};
+  double m_nodes_per_second{1e6};
+
+  // Guards the stages, m_stages[m_filling] receives submitted sequences.
+  // There is one stage per device plus the one that is filled.
+  std::mutex m_pipeline_mutex{};
+  std::vector<int> m_pool{};
+  std::vector<Stage> m_stages{};
+  std::vector<bool> m_device_busy{};
+  std::size_t m_filling{0};
+
+  // The kernels cannot check the timer, they get the remaining time as a
+  // number of nodes instead. A search that runs out of them is unfinished.
+  auto node_budget() -> std::size_t {
+    constexpr std::size_t unlimited = std::numeric_limits<std::size_t>::max();
+    const double time = remaining_time();
+    if (time < 0) {
+      return unlimited;
+    }
+    return static_cast<std::size_t>(std::min(
+        time * m_nodes_per_second, static_cast<double>(unlimited / 2)));
+  }
+
+  auto launch_stage(Stage& stage, Incumbent& incumbent) -> void;
 };
 
 } // namespace jcdp::scheduler
@@ -0,0 +1,277 @@
+/******************************************************************************
+ * @file jcdp/scheduler/fixed_size_search.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides the serial
+ *        search of the branch & bound scheduler for sequences of bounded
+ *        length and a fixed amount of threads, with all of its state in
+ *        arrays.
+ ******************************************************************************/
+
+#ifndef JCDP_SCHEDULER_FIXED_SIZE_SEARCH_HPP_
+#define JCDP_SCHEDULER_FIXED_SIZE_SEARCH_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "jcdp/incumbent.hpp"
+#include "jcdp/scheduler/transposition_table.hpp"
+#include "jcdp/sequence.hpp"
+#include "jcdp/util/instrumentation.hpp"
+#include "jcdp/util/timer.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::scheduler {
+
+/******************************************************************************
+ * @brief Depth-first search over the schedules of a short sequence.
+ *
+ * Same search as the serial one of BranchAndBoundScheduler (same branching
+ * order, symmetry breaking, transposition table and bound), so it finds the
+ * same schedules. The sizes are compile-time constants and the sequence is
+ * unpacked into arrays, so the thread loop is unrolled and the state lives
+ * in registers and the stack instead of a deque and heap buffers. Bound is
+ * one of the lower bounds with static prepare_view() and evaluate(), the
+ * search itself provides its view.
+ ******************************************************************************/
+template<std::size_t MaxOps, std::size_t Threads, typename Bound>
+class FixedSizeSearch {
+   static_assert(MaxOps <= 64, "The scheduled operations form a 64 bit mask");
+
+ public:
+   FixedSizeSearch(
+        const Sequence& sequence, util::Timer& timer,
+        const Incumbent* incumbent, TranspositionTable& table,
+        std::vector<std::size_t>& state)
+      : m_length {sequence.length()}, m_timer {timer}, m_incumbent {incumbent},
+        m_table {table}, m_state {state} {
+      assert(m_length <= MaxOps);
+      for (std::size_t i = 0; i < m_length; ++i) {
+         m_fma[i] = sequence[i].fma;
+         m_start[i] = 0;
+         const std::optional<std::size_t> p = sequence.parent(i);
+         m_parent[i] = p.value_or(NO_PARENT);
+         m_children[i] = 0;
+      }
+      for (std::size_t i = 0; i < m_length; ++i) {
+         if (m_parent[i] != NO_PARENT) {
+            m_children[m_parent[i]] |= bit(i);
+         }
+      }
+      Bound::prepare_view(*this, m_scratch);
+   }
+
+   //! Look for a schedule better than best_makespan and write it into the
+   //! sequence. Returns its makespan (or best_makespan if there is none).
+   inline auto run(
+        Sequence& sequence, const std::size_t best_makespan,
+        const std::size_t lower_bound) -> std::size_t {
+      m_best_makespan = best_makespan;
+      m_lower_bound = lower_bound;
+      search();
+
+      if (m_best_makespan < best_makespan) {
+         for (std::size_t i = 0; i < m_length; ++i) {
+            sequence[i].thread = m_best_thread[i];
+            sequence[i].start_time = m_best_start[i];
+            sequence[i].is_scheduled = true;
+         }
+      }
+      return m_best_makespan;
+   }
+
+   // View of the current node for the bounds (see ScheduleView)
+
+   inline auto length() const -> std::size_t {
+      return m_length;
+   }
+
+   inline auto fma(const std::size_t i) const -> std::size_t {
+      return m_fma[i];
+   }
+
+   inline auto is_scheduled(const std::size_t i) const -> bool {
+      return m_scheduled & bit(i);
+   }
+
+   inline auto start_time(const std::size_t i) const -> std::size_t {
+      return m_start[i];
+   }
+
+   inline auto parent(const std::size_t i) const -> std::optional<std::size_t> {
+      if (m_parent[i] != NO_PARENT) {
+         return m_parent[i];
+      }
+      return {};
+   }
+
+   template<typename F>
+   inline auto for_each_child(const std::size_t i, F&& f) const -> void {
+      for (std::uint64_t m = m_children[i]; m != 0; m &= m - 1) {
+         f(static_cast<std::size_t>(std::countr_zero(m)));
+      }
+   }
+
+   inline auto thread_loads() const -> std::span<const std::size_t> {
+      return m_loads;
+   }
+
+   inline auto makespan() const -> std::size_t {
+      return m_makespan;
+   }
+
+ private:
+   static constexpr std::size_t NO_PARENT = MaxOps;
+
+   //! Scratch buffers of the bounds.
+   struct Scratch {
+      std::array<std::size_t, MaxOps> tails {};
+      std::array<std::size_t, MaxOps> finish_times {};
+      std::array<std::size_t, MaxOps> by_tail {};
+      std::array<std::size_t, MaxOps> by_fma {};
+      std::array<std::size_t, Threads> sorted_loads {};
+   };
+
+   // Sequence
+   std::size_t m_length;
+   std::array<std::size_t, MaxOps> m_fma {};
+   std::array<std::size_t, MaxOps> m_parent {};
+   std::array<std::uint64_t, MaxOps> m_children {};
+
+   // Current node
+   std::uint64_t m_scheduled {0};
+   std::array<std::size_t, MaxOps> m_start {};
+   std::array<std::size_t, MaxOps> m_thread {};
+   std::array<std::size_t, Threads> m_loads {};
+   std::size_t m_makespan {0};
+   Scratch m_scratch {};
+
+   // Best schedule
+   std::size_t m_best_makespan {0};
+   std::size_t m_lower_bound {0};
+   std::array<std::size_t, MaxOps> m_best_start {};
+   std::array<std::size_t, MaxOps> m_best_thread {};
+
+   util::Timer& m_timer;
+   const Incumbent* m_incumbent;
+   TranspositionTable& m_table;
+   std::vector<std::size_t>& m_state;
+
+   inline static constexpr auto bit(const std::size_t i) -> std::uint64_t {
+      return std::uint64_t {1} << i;
+   }
+
+   inline auto pruning_bound() const -> std::size_t {
+      if (m_incumbent) {
+         return std::min(m_best_makespan, m_incumbent->makespan());
+      }
+      return m_best_makespan;
+   }
+
+   //! See the transposition table of BranchAndBoundScheduler::search().
+   inline auto dominated() -> bool {
+      if (!m_table.enabled()) {
+         return false;
+      }
+
+      m_state.assign(m_loads.cbegin(), m_loads.cend());
+      std::ranges::sort(m_state);
+      for (std::size_t i = 0; i < m_length; ++i) {
+         const std::size_t p = m_parent[i];
+         if (is_scheduled(i) && (p == NO_PARENT || !is_scheduled(p))) {
+            m_state.push_back(m_start[i] + m_fma[i]);
+         }
+      }
+      m_state.push_back(m_makespan);
+      if (!m_table.dominated(m_scheduled, m_state)) {
+         return false;
+      }
+      util::count(util::Counter::PRUNED_DOMINATED);
+      return true;
+   }
+
+   //! Returns true if the search is over.
+   auto search() -> bool {
+      if (!m_timer.remaining_time()) {
+         return true;
+      }
+      util::count(util::Counter::SCHEDULER_NODES);
+
+      bool everything_scheduled = true;
+      for (std::size_t op_idx = 0; op_idx < m_length; ++op_idx) {
+         if (is_scheduled(op_idx)) {
+            continue;
+         }
+         everything_scheduled = false;
+
+         if ((m_children[op_idx] & ~m_scheduled) != 0) {
+            continue;
+         }
+
+         m_scheduled |= bit(op_idx);
+         std::size_t start = 0;
+         for_each_child(op_idx, [&](const std::size_t child) {
+            start = std::max(start, m_start[child] + m_fma[child]);
+         });
+
+         for (std::size_t t = 0; t < Threads; ++t) {
+            // Threads with the same load are interchangeable
+            if (std::find(m_loads.cbegin(), m_loads.cbegin() + t, m_loads[t]) !=
+                m_loads.cbegin() + t) {
+               continue;
+            }
+
+            const std::size_t old_start_time = m_start[op_idx];
+            const std::size_t start_time = std::max(m_loads[t], start);
+            m_start[op_idx] = start_time;
+
+            const std::size_t old_thread_load = m_loads[t];
+            m_loads[t] = start_time + m_fma[op_idx];
+
+            const std::size_t old_makespan = m_makespan;
+            m_makespan = std::max(m_makespan, m_loads[t]);
+
+            util::count(util::Counter::BOUND_EVALUATIONS);
+            const bool promising = Bound::evaluate(*this, m_scratch) <
+                                   pruning_bound();
+            if (!promising) {
+               util::count(util::Counter::PRUNED_LOWER_BOUND);
+            }
+
+            if (promising && !dominated()) {
+               m_thread[op_idx] = t;
+               if (search()) {
+                  return true;
+               }
+            }
+
+            m_loads[t] = old_thread_load;
+            m_makespan = old_makespan;
+            m_start[op_idx] = old_start_time;
+         }
+
+         m_scheduled &= ~bit(op_idx);
+      }
+
+      if (everything_scheduled && m_makespan < m_best_makespan) {
+         m_best_makespan = m_makespan;
+         m_best_start = m_start;
+         m_best_thread = m_thread;
+         return m_best_makespan <= m_lower_bound;
+      }
+      return false;
+   }
+};
+
+}  // namespace jcdp::scheduler
+
+#endif  // JCDP_SCHEDULER_FIXED_SIZE_SEARCH_HPP_
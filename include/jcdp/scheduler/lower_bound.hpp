@@ -0,0 +1,434 @@
+/******************************************************************************
+ * @file jcdp/scheduler/lower_bound.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides lower bounds on
+ *        the makespan of all completions of a partial schedule, which the
+ *        branch & bound scheduler uses for pruning.
+ ******************************************************************************/
+
+#ifndef JCDP_SCHEDULER_LOWER_BOUND_HPP_
+#define JCDP_SCHEDULER_LOWER_BOUND_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "jcdp/operation.hpp"
+#include "jcdp/sequence.hpp"
+#include "jcdp/workspace.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::scheduler {
+
+/******************************************************************************
+ * @brief Node of the branch & bound scheduler.
+ *
+ * Scheduled operations have their thread and start time set. All others are
+ * appended to one of the threads, i.e. they start after its current load at
+ * the earliest.
+ ******************************************************************************/
+struct PartialSchedule {
+   const Sequence& sequence;
+   const std::vector<std::size_t>& thread_loads;
+   std::size_t makespan {0};
+   std::size_t idling_time {0};
+   std::size_t sequential_makespan {0};
+};
+
+/******************************************************************************
+ * @brief Read-only view of a partial schedule on a sequence.
+ *
+ * The bounds are implemented as templates over such a view and their
+ * scratch buffers, so that searches with their own (e.g. fixed-size) state
+ * can use them as well, see FixedSizeSearch. A view has to provide the same
+ * members, buffers are vectors or arrays that are large enough.
+ ******************************************************************************/
+class ScheduleView {
+ public:
+   explicit ScheduleView(
+        const Sequence& sequence,
+        const std::span<const std::size_t> thread_loads = {},
+        const std::size_t makespan = 0)
+      : m_sequence {sequence}, m_thread_loads {thread_loads},
+        m_makespan {makespan} {}
+
+   explicit ScheduleView(const PartialSchedule& node)
+      : ScheduleView(node.sequence, node.thread_loads, node.makespan) {}
+
+   inline auto length() const -> std::size_t {
+      return m_sequence.length();
+   }
+
+   inline auto fma(const std::size_t i) const -> std::size_t {
+      return m_sequence[i].fma;
+   }
+
+   inline auto is_scheduled(const std::size_t i) const -> bool {
+      return m_sequence[i].is_scheduled;
+   }
+
+   inline auto start_time(const std::size_t i) const -> std::size_t {
+      return m_sequence[i].start_time;
+   }
+
+   inline auto parent(const std::size_t i) const -> std::optional<std::size_t> {
+      return m_sequence.parent(i);
+   }
+
+   template<typename F>
+   inline auto for_each_child(const std::size_t i, F&& f) const -> void {
+      m_sequence.for_each_child(i, std::forward<F>(f));
+   }
+
+   inline auto thread_loads() const -> std::span<const std::size_t> {
+      return m_thread_loads;
+   }
+
+   inline auto makespan() const -> std::size_t {
+      return m_makespan;
+   }
+
+ private:
+   const Sequence& m_sequence;
+   std::span<const std::size_t> m_thread_loads;
+   std::size_t m_makespan;
+};
+
+/******************************************************************************
+ * @brief Strategy that bounds the makespan of a partial schedule from below.
+ *
+ * The bounds are stateless, so that a single instance can be shared by all
+ * threads. Everything that depends on the sequence is stored in the
+ * workspace of the calling thread by prepare(), which is called once per
+ * search before any bound().
+ ******************************************************************************/
+class LowerBound {
+ public:
+   virtual ~LowerBound() = default;
+
+   virtual auto prepare(const Sequence&, Workspace::Local&) const -> void {}
+
+   //! Bound on the makespan of every completion, at least the makespan.
+   virtual auto bound(const PartialSchedule&, Workspace::Local&) const
+        -> std::size_t = 0;
+
+ protected:
+   inline static auto ensure_size(
+        std::vector<std::size_t>& buffer, const std::size_t size) -> void {
+      buffer.resize(size);
+   }
+
+   template<std::size_t N>
+   inline static auto ensure_size(
+        [[maybe_unused]] std::array<std::size_t, N>& buffer,
+        [[maybe_unused]] const std::size_t size) -> void {
+      assert(size <= N);
+   }
+
+   //! Sum of the fmas of the ancestors of every operation, i.e. the time
+   //! from its end to the end of the root (which is needed at the earliest).
+   template<typename View, typename Buffer>
+   inline static auto compute_tails(const View& sequence, Buffer& tails)
+        -> void {
+      ensure_size(tails, sequence.length());
+      for (std::size_t i = sequence.length(); i-- > 0;) {
+         const std::optional<std::size_t> p = sequence.parent(i);
+         assert(!p || *p > i);
+         tails[i] = p ? tails[*p] + sequence.fma(*p) : 0;
+      }
+   }
+
+   //! The first length operations sorted by descending key, ties by index.
+   template<typename Key, typename Buffer>
+   inline static auto sort_by(
+        const Key& key, const std::size_t length, Buffer& order) -> void {
+      ensure_size(order, length);
+      const auto begin = order.begin();
+      std::iota(begin, begin + length, 0);
+      std::stable_sort(
+           begin, begin + length, [&key](std::size_t a, std::size_t b) {
+              return key[a] > key[b];
+           });
+   }
+
+   //! Earliest time at which threads with the (ascending) loads can have
+   //! processed work on top of them, if it can be split arbitrarily.
+   inline static auto water_level(
+        const std::span<const std::size_t> sorted_loads, const std::size_t work)
+        -> std::size_t {
+      assert(!sorted_loads.empty());
+
+      std::size_t sum = 0;
+      for (std::size_t k = 0; k < sorted_loads.size(); ++k) {
+         sum += sorted_loads[k];
+         const std::size_t level = (sum + work + k) / (k + 1);
+         if (k + 1 == sorted_loads.size() || level <= sorted_loads[k + 1]) {
+            return level;
+         }
+      }
+      return sum;
+   }
+
+   //! Thread loads of the node in ascending order, stored in the buffer.
+   template<typename View, typename Buffer>
+   inline static auto sort_loads(const View& node, Buffer& sorted_loads)
+        -> std::span<const std::size_t> {
+      const std::span<const std::size_t> loads = node.thread_loads();
+      ensure_size(sorted_loads, loads.size());
+      std::copy(loads.begin(), loads.end(), sorted_loads.begin());
+      std::sort(sorted_loads.begin(), sorted_loads.begin() + loads.size());
+      return {sorted_loads.data(), loads.size()};
+   }
+};
+
+/******************************************************************************
+ * @brief Average load and critical path of the scheduled operations.
+ *
+ * The original bound of the branch & bound scheduler. The critical path uses
+ * the start times of all operations, it is only valid if the ones of the
+ * unscheduled operations are 0.
+ ******************************************************************************/
+class CriticalPathBound : public LowerBound {
+ public:
+   inline auto bound(const PartialSchedule& node, Workspace::Local&) const
+        -> std::size_t override final {
+      const std::size_t threads = node.thread_loads.size();
+      return std::max(
+           {node.makespan,
+            (node.idling_time + node.sequential_makespan) / threads,
+            node.sequence.critical_path()});
+   }
+};
+
+/******************************************************************************
+ * @brief Longest remaining path to the root.
+ *
+ * Every unscheduled operation starts once all of its operands are finished
+ * and not before the least loaded thread is free. After it, all of its
+ * ancestors have to run one after another.
+ ******************************************************************************/
+class PathBound : public LowerBound {
+ public:
+   inline auto prepare(const Sequence& sequence, Workspace::Local& local) const
+        -> void override {
+      prepare_view(ScheduleView(sequence), local);
+   }
+
+   inline auto bound(const PartialSchedule& node, Workspace::Local& local)
+        const -> std::size_t override {
+      return evaluate(ScheduleView(node), local);
+   }
+
+   template<typename View, typename Scratch>
+   inline static auto prepare_view(const View& sequence, Scratch& scratch)
+        -> void {
+      compute_tails(sequence, scratch.tails);
+   }
+
+   template<typename View, typename Scratch>
+   inline static auto evaluate(const View& node, Scratch& scratch)
+        -> std::size_t {
+      const std::size_t min_load = std::ranges::min(node.thread_loads());
+
+      // Operands precede their operation in the sequence
+      auto& finish_times = scratch.finish_times;
+      ensure_size(finish_times, node.length());
+
+      std::size_t lb = node.makespan();
+      for (std::size_t i = 0; i < node.length(); ++i) {
+         if (node.is_scheduled(i)) {
+            finish_times[i] = node.start_time(i) + node.fma(i);
+            continue;
+         }
+
+         std::size_t start = min_load;
+         node.for_each_child(i, [&](const std::size_t child) {
+            start = std::max(start, finish_times[child]);
+         });
+         finish_times[i] = start + node.fma(i);
+         lb = std::max(lb, finish_times[i] + scratch.tails[i]);
+      }
+      return lb;
+   }
+};
+
+/******************************************************************************
+ * @brief Level bound for in-trees (Hu, Fernandez & Bussell).
+ *
+ * An unscheduled operation with a tail of at least lambda has to be done
+ * lambda before the makespan C, so the threads have to process all of these
+ * operations on top of their loads until C - lambda. For lambda = 0 this is
+ * the load bound with perfect balancing of the remaining work.
+ ******************************************************************************/
+class LevelBound : public LowerBound {
+ public:
+   inline auto prepare(const Sequence& sequence, Workspace::Local& local) const
+        -> void override {
+      prepare_view(ScheduleView(sequence), local);
+   }
+
+   inline auto bound(const PartialSchedule& node, Workspace::Local& local)
+        const -> std::size_t override {
+      return evaluate(ScheduleView(node), local);
+   }
+
+   template<typename View, typename Scratch>
+   inline static auto prepare_view(const View& sequence, Scratch& scratch)
+        -> void {
+      compute_tails(sequence, scratch.tails);
+      sort_by(scratch.tails, sequence.length(), scratch.by_tail);
+   }
+
+   template<typename View, typename Scratch>
+   inline static auto evaluate(const View& node, Scratch& scratch)
+        -> std::size_t {
+      const auto& tails = scratch.tails;
+      const auto& by_tail = scratch.by_tail;
+      const std::span<const std::size_t> sorted_loads = sort_loads(
+           node, scratch.sorted_loads);
+
+      std::size_t lb = node.makespan();
+      std::size_t work = 0;
+      for (std::size_t k = 0; k < node.length(); ++k) {
+         const std::size_t i = by_tail[k];
+         if (!node.is_scheduled(i)) {
+            work += node.fma(i);
+         }
+
+         // Once per distinct tail, with all the work of at least that tail
+         const bool last = k + 1 == node.length() ||
+                           tails[by_tail[k + 1]] != tails[i];
+         if (last && work > 0) {
+            lb = std::max(lb, tails[i] + water_level(sorted_loads, work));
+         }
+      }
+      return lb;
+   }
+};
+
+/******************************************************************************
+ * @brief Operations that have to share a thread.
+ *
+ * Of the threads + 1 longest unscheduled operations two run on the same
+ * thread, one after the other, after the load of that thread.
+ ******************************************************************************/
+class NonOverlapBound : public LowerBound {
+ public:
+   inline auto prepare(const Sequence& sequence, Workspace::Local& local) const
+        -> void override {
+      prepare_view(ScheduleView(sequence), local);
+   }
+
+   inline auto bound(const PartialSchedule& node, Workspace::Local& local)
+        const -> std::size_t override {
+      return evaluate(ScheduleView(node), local);
+   }
+
+   //! Uses finish_times as scratch for the fmas.
+   template<typename View, typename Scratch>
+   inline static auto prepare_view(const View& sequence, Scratch& scratch)
+        -> void {
+      auto& fmas = scratch.finish_times;
+      ensure_size(fmas, sequence.length());
+      for (std::size_t i = 0; i < sequence.length(); ++i) {
+         fmas[i] = sequence.fma(i);
+      }
+      sort_by(fmas, sequence.length(), scratch.by_fma);
+   }
+
+   template<typename View, typename Scratch>
+   inline static auto evaluate(const View& node, Scratch& scratch)
+        -> std::size_t {
+      const std::span<const std::size_t> loads = node.thread_loads();
+      const std::size_t threads = loads.size();
+
+      // Find the threads-th and (threads + 1)-th longest operation
+      std::size_t count = 0;
+      std::size_t fma_t = 0;
+      for (std::size_t k = 0; k < node.length(); ++k) {
+         const std::size_t i = scratch.by_fma[k];
+         if (node.is_scheduled(i)) {
+            continue;
+         }
+         if (++count == threads) {
+            fma_t = node.fma(i);
+         } else if (count == threads + 1) {
+            const std::size_t min_load = std::ranges::min(loads);
+            return std::max(node.makespan(), min_load + fma_t + node.fma(i));
+         }
+      }
+      return node.makespan();
+   }
+};
+
+/******************************************************************************
+ * @brief Maximum of the path, level and non-overlap bound.
+ ******************************************************************************/
+class CombinedBound : public LowerBound {
+ public:
+   inline auto prepare(const Sequence& sequence, Workspace::Local& local) const
+        -> void override final {
+      prepare_view(ScheduleView(sequence), local);
+   }
+
+   inline auto bound(const PartialSchedule& node, Workspace::Local& local)
+        const -> std::size_t override final {
+      return evaluate(ScheduleView(node), local);
+   }
+
+   template<typename View, typename Scratch>
+   inline static auto prepare_view(const View& sequence, Scratch& scratch)
+        -> void {
+      // The non-overlap bound uses finish_times as scratch, which the path
+      // bound only needs in bound()
+      NonOverlapBound::prepare_view(sequence, scratch);
+      LevelBound::prepare_view(sequence, scratch);
+   }
+
+   template<typename View, typename Scratch>
+   inline static auto evaluate(const View& node, Scratch& scratch)
+        -> std::size_t {
+      return std::max(
+           {PathBound::evaluate(node, scratch),
+            LevelBound::evaluate(node, scratch),
+            NonOverlapBound::evaluate(node, scratch)});
+   }
+};
+
+//! Shared instance of the bound with the given name (critical_path, path,
+//! level, non_overlap or combined).
+inline auto lower_bound(const std::string& name) -> const LowerBound& {
+   static const CriticalPathBound critical_path;
+   static const PathBound path;
+   static const LevelBound level;
+   static const NonOverlapBound non_overlap;
+   static const CombinedBound combined;
+
+   if (name == "critical_path") {
+      return critical_path;
+   } else if (name == "path") {
+      return path;
+   } else if (name == "level") {
+      return level;
+   } else if (name == "non_overlap") {
+      return non_overlap;
+   } else if (name == "combined") {
+      return combined;
+   }
+   throw std::invalid_argument("Unknown scheduler lower bound \"" + name + "\"");
+}
+
+}  // namespace jcdp::scheduler
+
+#endif  // JCDP_SCHEDULER_LOWER_BOUND_HPP_
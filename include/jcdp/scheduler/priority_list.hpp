@@ -14,15 +14,18 @@
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
 #include <algorithm>
+#include <cassert>
 #include <cstddef>
+#include <iterator>
 #include <numeric>
-#include <queue>
-#include <utility>
+#include <optional>
 #include <vector>
 
+#include "jcdp/incumbent.hpp"
 #include "jcdp/operation.hpp"
 #include "jcdp/scheduler/scheduler.hpp"
 #include "jcdp/sequence.hpp"
+#include "jcdp/workspace.hpp"
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
@@ -31,60 +34,101 @@ namespace jcdp::scheduler {
 class PriorityListScheduler : public Scheduler {
  public:
    virtual auto schedule_impl(
-        Sequence& sequence, const std::size_t usable_threads, const std::size_t)
-        -> std::size_t override final {
-
-      std::vector<std::size_t> queue_cont(sequence.length());
-      std::iota(queue_cont.begin(), queue_cont.end(), 0);
-
-      std::priority_queue queue(
-           [&sequence](const std::size_t& op_idx1, const std::size_t& op_idx2)
-                -> bool {
-              const std::size_t level_1 = sequence.level(op_idx1);
-              const std::size_t level_2 = sequence.level(op_idx2);
-              if (level_1 == level_2) {
-                 return sequence.at(op_idx1).fma < sequence.at(op_idx2).fma;
-              }
-              return sequence.level(op_idx1) < sequence.level(op_idx2);
-           },
-           std::move(queue_cont));
+        Sequence& sequence, const std::size_t usable_threads, const std::size_t,
+        const Incumbent*) -> std::size_t override final {
+
+      std::optional<Workspace::Local> own_workspace;
+      Workspace::Local& workspace = local_workspace(own_workspace);
+
+      const std::size_t length = sequence.length();
+
+      // Operands precede their operation in the sequence, so a single
+      // backward pass yields all levels
+      std::vector<std::size_t>& levels = workspace.levels;
+      levels.resize(length);
+      for (std::size_t i = length; i-- > 0;) {
+         const std::optional<std::size_t> p = sequence.parent(i);
+         assert(!p || *p > i);
+         levels[i] = p ? levels[*p] + 1 : 1;
+      }
+
+      const auto lower_priority =
+           [&sequence, &levels](
+                const std::size_t& op_idx1, const std::size_t& op_idx2) -> bool {
+         if (levels[op_idx1] == levels[op_idx2]) {
+            return sequence[op_idx1].fma < sequence[op_idx2].fma;
+         }
+         return levels[op_idx1] < levels[op_idx2];
+      };
+
+      // Max-heap of the operation indices (same as a std::priority_queue, but
+      // on a reusable buffer)
+      std::vector<std::size_t>& queue = workspace.indices;
+      queue.resize(length);
+      std::iota(queue.begin(), queue.end(), 0);
+      std::make_heap(queue.begin(), queue.end(), lower_priority);
 
       // Reset potential previous schedule
       for (Operation& op : sequence) {
          op.is_scheduled = false;
       }
 
-      std::vector<std::size_t> thread_loads(usable_threads, 0);
+      // Operands have a higher level, i.e. they are scheduled first and
+      // push the ready time of their parent
+      std::vector<std::size_t>& ready_times = workspace.ready_times;
+      ready_times.assign(length, 0);
+
+      // Threads sorted by load, ties by index
+      std::vector<std::size_t>& thread_loads = workspace.thread_loads;
+      thread_loads.assign(usable_threads, 0);
+      std::vector<std::size_t>& by_load = workspace.threads_by_load;
+      by_load.resize(usable_threads);
+      std::iota(by_load.begin(), by_load.end(), 0);
+      const auto less_loaded = [&thread_loads](
+                                    const std::size_t t1, const std::size_t t2) {
+         return thread_loads[t1] < thread_loads[t2] ||
+                (thread_loads[t1] == thread_loads[t2] && t1 < t2);
+      };
+
       while (!queue.empty()) {
-         const std::size_t op_idx = queue.top();
-         const std::size_t earliest_start = sequence.earliest_start(op_idx);
+         const std::size_t op_idx = queue.front();
+         const std::size_t earliest_start = ready_times[op_idx];
+
+         // Start as early as possible with the least idle time, i.e. on the
+         // most loaded thread that is free at the earliest start. Without
+         // one the least loaded thread. Ties go to the lowest index.
+         auto it = std::upper_bound(
+              by_load.begin(), by_load.end(), earliest_start,
+              [&thread_loads](const std::size_t time, const std::size_t t) {
+                 return time < thread_loads[t];
+              });
+         if (it != by_load.begin()) {
+            const std::size_t load = thread_loads[*std::prev(it)];
+            it = std::lower_bound(
+                 by_load.begin(), it, load,
+                 [&thread_loads](const std::size_t t, const std::size_t time) {
+                    return thread_loads[t] < time;
+                 });
+         }
 
          Operation& op = sequence[op_idx];
-         op.thread = 0;
-         op.start_time = std::max(thread_loads[0], earliest_start);
-         std::size_t current_idle_time = op.start_time - thread_loads[0];
-
-         for (size_t t = 1; t < usable_threads; t++) {
-            const std::size_t start_on_t = std::max(
-                 thread_loads[t], earliest_start);
-            const std::size_t idle_on_t = start_on_t - thread_loads[t];
-
-            if (start_on_t < op.start_time) {
-               op.thread = t;
-               op.start_time = start_on_t;
-               current_idle_time = idle_on_t;
-            } else if (start_on_t == op.start_time) {
-               if (idle_on_t < current_idle_time) {
-                  op.thread = t;
-                  op.start_time = start_on_t;
-                  current_idle_time = idle_on_t;
-               }
-            }
+         op.thread = *it;
+         op.start_time = std::max(thread_loads[op.thread], earliest_start);
+         op.is_scheduled = true;
+
+         const std::size_t end_time = op.start_time + op.fma;
+         thread_loads[op.thread] = end_time;
+         std::rotate(
+              it, std::next(it),
+              std::lower_bound(
+                   std::next(it), by_load.end(), op.thread, less_loaded));
+
+         if (const std::optional<std::size_t> p = sequence.parent(op_idx)) {
+            ready_times[*p] = std::max(ready_times[*p], end_time);
          }
 
-         thread_loads[op.thread] = op.start_time + op.fma;
-         op.is_scheduled = true;
-         queue.pop();
+         std::pop_heap(queue.begin(), queue.end(), lower_priority);
+         queue.pop_back();
       }
 
       return sequence.makespan();
@@ -0,0 +1,156 @@
+/******************************************************************************
+ * @file jcdp/scheduler/schedule_cache.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides a concurrent cache
+ *        that memoizes the scheduling results of elimination sequences. Two
+ *        sequences that contain the same operations (in any order) have the
+ *        same precedence DAG and therefore the same optimal schedule.
+ ******************************************************************************/
+
+#ifndef JCDP_SCHEDULER_SCHEDULE_CACHE_HPP_
+#define JCDP_SCHEDULER_SCHEDULE_CACHE_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <algorithm>
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "jcdp/operation.hpp"
+#include "jcdp/scheduler/scheduler.hpp"
+#include "jcdp/sequence.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::scheduler {
+
+struct ScheduleCacheEntry {
+   //! Makespan that rescheduling the sequence cannot improve upon.
+   std::size_t makespan {0};
+   //! Whether makespan is the proven optimal makespan of the sequence.
+   bool optimal {false};
+};
+
+class ScheduleCache {
+ public:
+   //! Canonical description of a single operation (ignores the schedule).
+   struct OpKey {
+      Action action {Action::NONE};
+      Mode mode {Mode::NONE};
+      std::size_t j {0};
+      std::size_t k {0};
+      std::size_t i {0};
+      std::size_t fma {0};
+
+      auto operator<=>(const OpKey&) const = default;
+   };
+
+   //! Sorted multiset of operations plus the amount of usable threads.
+   struct Key {
+      std::vector<OpKey> ops {};
+      std::size_t threads {0};
+
+      auto operator==(const Key&) const -> bool = default;
+   };
+
+   ScheduleCache() = default;
+
+   ScheduleCache(const ScheduleCache&) = delete;
+   auto operator=(const ScheduleCache&) -> ScheduleCache& = delete;
+
+   //! Threads are clamped to the amount of accumulations (like the
+   //! schedulers do), so a sweep over thread counts shares the entries.
+   inline static auto make_key(
+        const Sequence& sequence, const std::size_t threads) -> Key {
+      Key key {.threads = Scheduler::usable_threads(sequence, threads)};
+      key.ops.reserve(sequence.length());
+      for (const Operation& op : sequence) {
+         key.ops.push_back(OpKey {
+              .action = op.action,
+              .mode = op.mode,
+              .j = op.j,
+              .k = op.k,
+              .i = op.i,
+              .fma = op.fma});
+      }
+      std::ranges::sort(key.ops);
+      return key;
+   }
+
+   inline auto find(const Key& key) const -> std::optional<ScheduleCacheEntry> {
+      const std::size_t h = KeyHash {}(key);
+      const Shard& shard = m_shards[h % SHARDS];
+
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      const auto it = shard.entries.find(key);
+      if (it == shard.entries.end()) {
+         return {};
+      }
+      return it->second;
+   }
+
+   //! Insert the entry or merge it with an existing one (keeping the
+   //! stronger bound). Returns false if the key was already present.
+   inline auto insert(const Key& key, const ScheduleCacheEntry& entry) -> bool {
+      const std::size_t h = KeyHash {}(key);
+      Shard& shard = m_shards[h % SHARDS];
+
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      const auto [it, inserted] = shard.entries.try_emplace(key, entry);
+      if (!inserted) {
+         ScheduleCacheEntry& old = it->second;
+         if (entry.optimal) {
+            old = entry;
+         } else if (!old.optimal) {
+            old.makespan = std::max(old.makespan, entry.makespan);
+         }
+      }
+      return inserted;
+   }
+
+   inline auto clear() -> void {
+      for (Shard& shard : m_shards) {
+         std::lock_guard<std::mutex> lock(shard.mutex);
+         shard.entries.clear();
+      }
+   }
+
+ private:
+   static constexpr std::size_t SHARDS = 64;
+
+   struct KeyHash {
+      inline auto operator()(const Key& key) const -> std::size_t {
+         std::size_t h = std::hash<std::size_t> {}(key.threads);
+         const auto combine = [&h](const std::size_t v) {
+            h ^= std::hash<std::size_t> {}(v) + 0x9e3779b97f4a7c15 + (h << 6) +
+                 (h >> 2);
+         };
+         for (const OpKey& op : key.ops) {
+            combine(static_cast<std::size_t>(op.action) << 8 |
+                    static_cast<std::size_t>(op.mode));
+            combine(op.j);
+            combine(op.k);
+            combine(op.i);
+            combine(op.fma);
+         }
+         return h;
+      }
+   };
+
+   struct Shard {
+      mutable std::mutex mutex;
+      std::unordered_map<Key, ScheduleCacheEntry, KeyHash> entries;
+   };
+
+   std::array<Shard, SHARDS> m_shards {};
+};
+
+}  // namespace jcdp::scheduler
+
+#endif  // JCDP_SCHEDULER_SCHEDULE_CACHE_HPP_
@@ -11,12 +11,17 @@
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
+#include <algorithm>
 #include <cstddef>
 #include <limits>
+#include <optional>
 #include <print>
 
+#include "jcdp/incumbent.hpp"
 #include "jcdp/sequence.hpp"
+#include "jcdp/util/instrumentation.hpp"
 #include "jcdp/util/timer.hpp"
+#include "jcdp/workspace.hpp"
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
@@ -27,24 +32,95 @@ class Scheduler : public util::Timer {
    Scheduler() = default;
    virtual ~Scheduler() = default;
 
+   //! Schedule the sequence on the given amount of threads. Schedules that
+   //! are not better than upper_bound (or the optional incumbent, which
+   //! may improve while scheduling) can be discarded.
    inline auto schedule(
         Sequence& sequence, const std::size_t threads,
-        const std::size_t upper_bound = std::numeric_limits<std::size_t>::max())
-        -> std::size_t {
+        const std::size_t upper_bound = std::numeric_limits<std::size_t>::max(),
+        const Incumbent* incumbent = nullptr) -> std::size_t {
+      const util::ScopedPhase phase("schedule");
+      util::count(util::Counter::SCHEDULE_CALLS);
 
       start_timer();
+      return schedule_impl(
+           sequence, usable_threads(sequence, threads), upper_bound, incumbent);
+   }
 
-      // We can never use more threads than we have accumulations
-      std::size_t usable_threads = sequence.count_accumulations();
-      if (threads > 0 && threads < usable_threads) {
-         usable_threads = threads;
+   //! We can never use more threads than we have accumulations.
+   inline static auto usable_threads(
+        const Sequence& sequence, const std::size_t threads) -> std::size_t {
+      std::size_t usable = sequence.count_accumulations();
+      if (threads > 0 && threads < usable) {
+         usable = threads;
       }
-
-      return schedule_impl(sequence, usable_threads, upper_bound);
+      return usable;
    }
 
-   virtual auto schedule_impl(Sequence&, const std::size_t, const std::size_t)
+   virtual auto schedule_impl(
+        Sequence&, const std::size_t, const std::size_t, const Incumbent*)
         -> std::size_t = 0;
+
+   //! Whether a schedule that finished in time is optimal, i.e. the result
+   //! only depends on the precedence DAG and not on the operation order.
+   virtual auto proves_optimality() const -> bool {
+      return false;
+   }
+
+   //! Whether submit() may return before the sequence is scheduled.
+   virtual auto is_asynchronous() const -> bool {
+      return false;
+   }
+
+   //! Schedule the sequence and publish the result to the incumbent. An
+   //! asynchronous scheduler may do so later, at the latest in wait(). The
+   //! upper bound is the makespan of the incumbent at that time.
+   virtual auto submit(
+        const Sequence& sequence, const std::size_t threads,
+        Incumbent& incumbent) -> void {
+      Sequence scheduled = sequence;
+      const std::size_t makespan = schedule(
+           scheduled, threads, incumbent.makespan(), &incumbent);
+      incumbent.update(scheduled, makespan);
+   }
+
+   //! Finish all sequences that were submitted so far.
+   virtual auto wait(Incumbent&) -> void {}
+
+   //! Reuse the buffers of the workspace instead of allocating per call.
+   inline auto set_workspace(Workspace* workspace) -> void {
+      m_workspace = workspace;
+   }
+
+ protected:
+   //! Bound workspace (if any), e.g. for schedulers used internally.
+   inline auto workspace_ptr() const -> Workspace* {
+      return m_workspace;
+   }
+
+   //! Scratch buffers of the calling thread. Falls back to freshly
+   //! allocated ones if no workspace is bound.
+   inline auto local_workspace(std::optional<Workspace::Local>& fallback)
+        -> Workspace::Local& {
+      Workspace::Local* local = m_workspace ? m_workspace->local() : nullptr;
+      if (!local) {
+         local = &fallback.emplace();
+      }
+      return *local;
+   }
+
+   //! Makespan a schedule has to beat to be of any use.
+   inline static auto pruning_bound(
+        const std::size_t best_makespan, const Incumbent* incumbent)
+        -> std::size_t {
+      if (incumbent) {
+         return std::min(best_makespan, incumbent->makespan());
+      }
+      return best_makespan;
+   }
+
+ private:
+   Workspace* m_workspace {nullptr};
 };
 
 }  // namespace jcdp::scheduler
@@ -0,0 +1,93 @@
+/******************************************************************************
+ * @file jcdp/scheduler/transposition_table.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides a table of the
+ *        states visited by the branch & bound scheduler, used to discard the
+ *        states that are dominated by one of them.
+ ******************************************************************************/
+
+#ifndef JCDP_SCHEDULER_TRANSPOSITION_TABLE_HPP_
+#define JCDP_SCHEDULER_TRANSPOSITION_TABLE_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::scheduler {
+
+/******************************************************************************
+ * @brief Visited states of one search, grouped by the set of scheduled ops.
+ *
+ * A state is described by values whose increase can never shorten any
+ * completion (e.g. sorted thread loads and finish times). States with the
+ * same mask have the same amount of values. A state is dominated by a
+ * visited one if none of its values is smaller, then its subtree cannot
+ * contain a better schedule than the subtree of the visited one. The table
+ * stops growing at its capacity, it keeps being queried.
+ ******************************************************************************/
+class TranspositionTable {
+ public:
+   //! Scanning the states of a mask is linear, so only that many are kept.
+   static constexpr std::size_t MAX_STATES_PER_MASK = 32;
+
+   //! Forget all states and keep at most capacity (0 = disabled).
+   inline auto clear(const std::size_t capacity) -> void {
+      m_states.clear();
+      m_size = 0;
+      m_capacity = capacity;
+   }
+
+   inline auto enabled() const -> bool {
+      return m_capacity > 0;
+   }
+
+   //! Whether the state is dominated by a visited one. If not, it is stored.
+   inline auto dominated(
+        const std::uint64_t mask, const std::vector<std::size_t>& state)
+        -> bool {
+      if (!enabled()) {
+         return false;
+      }
+
+      const auto it = m_states.find(mask);
+      const std::size_t width = state.size();
+      if (it != m_states.end()) {
+         const std::vector<std::size_t>& visited = it->second;
+         for (std::size_t offset = 0; offset < visited.size();
+              offset += width) {
+            if (std::equal(
+                     state.cbegin(), state.cend(), visited.cbegin() + offset,
+                     std::greater_equal<> {})) {
+               return true;
+            }
+         }
+      }
+
+      if (m_size < m_capacity) {
+         std::vector<std::size_t>& visited = it != m_states.end()
+                                                  ? it->second
+                                                  : m_states[mask];
+         if (visited.size() < MAX_STATES_PER_MASK * width) {
+            visited.insert(visited.end(), state.cbegin(), state.cend());
+            ++m_size;
+         }
+      }
+      return false;
+   }
+
+ private:
+   std::unordered_map<std::uint64_t, std::vector<std::size_t>> m_states {};
+   std::size_t m_size {0};
+   std::size_t m_capacity {0};
+};
+
+}  // namespace jcdp::scheduler
+
+#endif  // JCDP_SCHEDULER_TRANSPOSITION_TABLE_HPP_
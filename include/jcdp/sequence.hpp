@@ -11,8 +11,10 @@
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
 #include <algorithm>
+#include <bit>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <deque>  // IWYU pragma: export
 #include <format>
 #include <functional>
@@ -27,13 +29,60 @@
 
 namespace jcdp {
 
+//! Bitmask over the operations of a sequence (bit i <=> i-th operation).
+using DependencyMask = std::uint64_t;
+
 class Sequence : public std::deque<Operation> {
  public:
+   //! Sequences up to this length track their children as a bitmask.
+   static constexpr std::size_t MAX_TRACKED_LENGTH =
+        std::numeric_limits<DependencyMask>::digits;
+
+   //! Marks an operation without parent (the root of the in-tree).
+   static constexpr std::size_t NO_PARENT =
+        std::numeric_limits<std::size_t>::max();
+
    std::size_t best_makespan_output = 0;
 
    Sequence() = default;
 
-   explicit Sequence(Operation&& rhs) : std::deque<Operation> {rhs} {};
+   explicit Sequence(Operation&& rhs)
+      : std::deque<Operation> {rhs}, m_parents {NO_PARENT}, m_children {0} {};
+
+   //! Append an operation and link it into the in-tree dependencies.
+   inline auto push_back(const Operation& op) -> void {
+      const std::size_t op_idx = size();
+      std::deque<Operation>::push_back(op);
+      m_parents.push_back(NO_PARENT);
+      m_children.push_back(0);
+
+      for (std::size_t i = 0; i < op_idx; ++i) {
+         if (op < (*this)[i]) {
+            link(op_idx, i);
+         } else if ((*this)[i] < op) {
+            link(i, op_idx);
+         }
+      }
+   }
+
+   //! Remove the last operation and unlink it from the in-tree dependencies.
+   inline auto pop_back() -> void {
+      assert(!empty());
+      const std::size_t op_idx = size() - 1;
+
+      for_each_child(op_idx, [this](const std::size_t child) {
+         m_parents[child] = NO_PARENT;
+      });
+
+      const std::size_t p = m_parents[op_idx];
+      if (p != NO_PARENT && op_idx < MAX_TRACKED_LENGTH) {
+         m_children[p] &= ~bit(op_idx);
+      }
+
+      m_parents.pop_back();
+      m_children.pop_back();
+      std::deque<Operation>::pop_back();
+   }
 
    inline auto makespan(const std::optional<std::size_t> thread = {})
         -> std::size_t {
@@ -48,7 +97,7 @@ class Sequence : public std::deque<Operation> {
       return cost;
    }
 
-   inline auto sequential_makespan() -> std::size_t {
+   inline auto sequential_makespan() const -> std::size_t {
       return std::transform_reduce(
            cbegin(), cend(), static_cast<std::size_t>(0), std::plus<>(),
            [](const Operation& op) -> std::size_t {
@@ -61,11 +110,9 @@ class Sequence : public std::deque<Operation> {
       assert(op_idx < length());
 
       std::vector<std::size_t> child_ops;
-      for (std::size_t i = 0; i < length(); ++i) {
-         if (at(i) > at(op_idx)) {
-            child_ops.push_back(i);
-         }
-      }
+      for_each_child(op_idx, [&child_ops](const std::size_t child) {
+         child_ops.push_back(child);
+      });
 
       return child_ops;
    }
@@ -74,22 +121,20 @@ class Sequence : public std::deque<Operation> {
         -> std::optional<std::size_t> {
       assert(op_idx < length());
 
-      std::vector<std::size_t> child_ops;
-      for (std::size_t i = 0; i < length(); ++i) {
-         if (this[0][i] < this[0][op_idx]) {
-            return i;
-         }
+      if (m_parents[op_idx] != NO_PARENT) {
+         return m_parents[op_idx];
       }
 
       return {};
    }
 
    inline auto level(const std::size_t op_idx) const -> std::size_t {
-      std::optional<std::size_t> p = parent(op_idx);
-      if (p.has_value()) {
-         return level(p.value()) + 1;
+      std::size_t lvl = 1;
+      for (std::size_t p = m_parents[op_idx]; p != NO_PARENT;
+           p = m_parents[p]) {
+         ++lvl;
       }
-      return 1;
+      return lvl;
    }
 
    inline auto critical_path() const -> std::size_t {
@@ -103,34 +148,20 @@ class Sequence : public std::deque<Operation> {
    inline auto critical_path(
         const std::size_t op_idx, std::size_t start_time = 0) const
         -> std::size_t {
-      start_time = std::max(start_time, this[0][op_idx].start_time);
-      const std::size_t end_time = start_time + this[0][op_idx].fma;
-      std::optional<std::size_t> p = parent(op_idx);
-      if (p.has_value()) {
-         return critical_path(p.value(), end_time);
+      std::size_t end_time = start_time;
+      for (std::size_t idx = op_idx; idx != NO_PARENT; idx = m_parents[idx]) {
+         const Operation& op = (*this)[idx];
+         end_time = std::max(end_time, op.start_time) + op.fma;
       }
       return end_time;
    }
 
    inline auto is_schedulable(const std::size_t op_idx) const -> bool {
-      for (std::size_t i = 0; i < size(); i++) {
-         if (this[0][op_idx] < this[0][i]) {
-            if (!this[0][i].is_scheduled) {
-               return false;
-            }
-         }
-      }
-      return true;
-      /*
-      return std::all_of(
-           cbegin(), cend(), [this, op_idx](const Operation& op) -> bool {
-              if (at(op_idx) < op) {
-                 return op.is_scheduled;
-              }
-
-              return true;
-           });
-      */
+      bool schedulable = true;
+      for_each_child(op_idx, [this, &schedulable](const std::size_t child) {
+         schedulable &= (*this)[child].is_scheduled;
+      });
+      return schedulable;
    }
 
    inline auto is_scheduled() const -> bool {
@@ -140,32 +171,12 @@ class Sequence : public std::deque<Operation> {
    }
 
    inline auto earliest_start(const std::size_t op_idx) const -> std::size_t {
-
       std::size_t time = 0;
-      std::size_t max = 0;
-      for (std::size_t i = 0; i < size(); i++) {
-         if (this[0][op_idx] < this[0][i]) {
-            time = this[0][i].start_time + this[0][i].fma;
-         }
-         if (time > max ) {
-            max = time;
-         }
-         time = 0;
-      }
-      return max;
-      /*
-      return std::transform_reduce(
-           cbegin(), cend(), static_cast<std::size_t>(0),
-           [](const std::size_t lhs, const std::size_t rhs) -> std::size_t {
-              return std::max(lhs, rhs);
-           },
-           [this, op_idx](const Operation& op) -> std::size_t {
-              if (at(op_idx) < op) {
-                 return op.start_time + op.fma;
-              }
-              return 0;
-           });
-      */
+      for_each_child(op_idx, [this, &time](const std::size_t child) {
+         const Operation& op = (*this)[child];
+         time = std::max(time, op.start_time + op.fma);
+      });
+      return time;
    }
 
    inline auto count_accumulations() const -> std::size_t {
@@ -202,10 +213,67 @@ class Sequence : public std::deque<Operation> {
       return size();
    }
 
+   //! Placeholder operation of the worst possible sequence.
+   static constexpr Operation MAX_OPERATION {
+        .fma = std::numeric_limits<std::size_t>::max(), .is_scheduled = true};
+
    inline static auto make_max() -> Sequence {
-      return Sequence(Operation {
-           .fma = std::numeric_limits<std::size_t>::max(),
-           .is_scheduled = true});
+      return Sequence(Operation(MAX_OPERATION));
+   }
+
+   //! Remove all operations but keep the storage of the dependencies.
+   inline auto clear() -> void {
+      std::deque<Operation>::clear();
+      m_parents.clear();
+      m_children.clear();
+   }
+
+   //! Pre-size the dependency tracking for up to n operations.
+   inline auto reserve(const std::size_t n) -> void {
+      m_parents.reserve(n);
+      m_children.reserve(n);
+   }
+
+   //! Bitmask of the operations whose results are consumed by op_idx. Only
+   //! complete for sequences of at most MAX_TRACKED_LENGTH operations.
+   inline auto children_mask(const std::size_t op_idx) const
+        -> DependencyMask {
+      assert(op_idx < length());
+      return m_children[op_idx];
+   }
+
+   //! Call f(child_idx) for every operation consumed by op_idx.
+   template<typename F>
+   inline auto for_each_child(const std::size_t op_idx, F&& f) const -> void {
+      if (length() <= MAX_TRACKED_LENGTH) {
+         for (DependencyMask m = m_children[op_idx]; m != 0; m &= m - 1) {
+            f(static_cast<std::size_t>(std::countr_zero(m)));
+         }
+      } else {
+         for (std::size_t i = 0; i < length(); ++i) {
+            if (m_parents[i] == op_idx) {
+               f(i);
+            }
+         }
+      }
+   }
+
+ private:
+   //! Index of the operation that consumes the result of the i-th operation.
+   std::vector<std::size_t> m_parents {};
+   //! Bitmask of the operations consumed by the i-th operation.
+   std::vector<DependencyMask> m_children {};
+
+   inline static auto bit(const std::size_t op_idx) -> DependencyMask {
+      return static_cast<DependencyMask>(1) << op_idx;
+   }
+
+   inline auto link(const std::size_t parent_idx, const std::size_t child_idx)
+        -> void {
+      m_parents[child_idx] = parent_idx;
+      if (child_idx < MAX_TRACKED_LENGTH) {
+         m_children[parent_idx] |= bit(child_idx);
+      }
    }
 };
 
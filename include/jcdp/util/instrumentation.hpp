@@ -0,0 +1,376 @@
+/******************************************************************************
+ * @file jcdp/util/instrumentation.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides per-thread
+ *        performance counters, phase timers and a Chrome trace of the
+ *        phases. They are only recorded if JCDP_INSTRUMENTATION is defined,
+ *        otherwise all calls compile to nothing.
+ ******************************************************************************/
+
+#ifndef JCDP_UTIL_INSTRUMENTATION_HPP_
+#define JCDP_UTIL_INSTRUMENTATION_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "jcdp/util/properties.hpp"
+#include "jcdp/util/timer.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::util {
+
+#ifdef JCDP_INSTRUMENTATION
+inline constexpr bool INSTRUMENTATION = true;
+#else
+inline constexpr bool INSTRUMENTATION = false;
+#endif
+
+enum class Counter : std::size_t {
+   //! Nodes of the search over elimination sequences
+   OPTIMIZER_NODES = 0,
+   //! Nodes of the search over schedules
+   SCHEDULER_NODES,
+   //! Lower bounds computed by the branch & bound schedulers
+   BOUND_EVALUATIONS,
+   //! Sequences whose lower bound can't beat the incumbent
+   PRUNED_SEQUENCE_BOUND,
+   //! Schedules whose lower bound can't beat the best one
+   PRUNED_LOWER_BOUND,
+   //! Schedules dominated by a state of the transposition table
+   PRUNED_DOMINATED,
+   //! Sequences skipped via the schedule cache
+   PRUNED_SCHEDULE_CACHE,
+   TASKS_SPAWNED,
+   //! Tasks executed by another thread than the one that spawned them
+   TASKS_STOLEN,
+   SCHEDULE_CALLS,
+   //! Sequences and batches the GPU scheduler launched on the device
+   GPU_OFFLOADS,
+   //! Size of the buffers mapped for the launches
+   GPU_BYTES_MAPPED,
+   COUNT
+};
+
+inline constexpr std::size_t COUNTERS = static_cast<std::size_t>(
+     Counter::COUNT);
+
+inline constexpr std::array<std::string_view, COUNTERS> COUNTER_NAMES = {
+     "optimizer_nodes", "scheduler_nodes", "bound_evaluations",
+     "pruned_sequence_bound", "pruned_lower_bound", "pruned_dominated",
+     "pruned_schedule_cache", "tasks_spawned", "tasks_stolen",
+     "schedule_calls", "gpu_offloads", "gpu_bytes_mapped"};
+
+using CounterValues = std::array<std::uint64_t, COUNTERS>;
+
+//! Total time and amount of calls of a phase.
+struct PhaseTotal {
+   std::string name {};
+   double seconds {0};
+   std::uint64_t calls {0};
+};
+
+/******************************************************************************
+ * @brief Registry of the counters, phase timers and trace events of all
+ *        threads that recorded any.
+ *
+ * Every thread writes to its own record, the counters are read with relaxed
+ * atomics, so counters() may be called while a search runs. Everything else
+ * (phases(), the trace and reset()) has to be called while no instrumented
+ * code runs. Times are measured with a Timer that starts with the registry.
+ ******************************************************************************/
+class Instrumentation : public Properties {
+ public:
+   //! Trace events per thread, later phases are only timed.
+   static constexpr std::size_t MAX_TRACE_EVENTS = 1 << 20;
+
+   //! Phase that ran on a thread, in seconds since the start of the registry.
+   struct TraceEvent {
+      const char* name {nullptr};
+      double start {0};
+      double duration {0};
+   };
+
+   struct ThreadRecord {
+      std::size_t id {0};
+      std::array<std::atomic<std::uint64_t>, COUNTERS> counters {};
+      //! Phase names are string literals, so they are found by address
+      std::vector<std::pair<const char*, PhaseTotal>> phases {};
+      std::vector<TraceEvent> events {};
+   };
+
+   Instrumentation() {
+      register_property(
+           m_trace_file, "trace_file",
+           "Chrome trace (JSON) file the phases of all threads are written "
+           "to, e.g. for Perfetto. Needs a build with JCDP_INSTRUMENTATION.");
+      register_property(
+           m_print_counters, "print_counters",
+           "Wether the performance counters are printed at the end. Needs a "
+           "build with JCDP_INSTRUMENTATION.");
+   }
+
+   Instrumentation(const Instrumentation&) = delete;
+   auto operator=(const Instrumentation&) -> Instrumentation& = delete;
+
+   //! Record of the calling thread.
+   inline auto local() -> ThreadRecord& {
+      thread_local ThreadRecord* record = nullptr;
+      if (!record) {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         record = m_threads.emplace_back(
+              std::make_unique<ThreadRecord>()).get();
+         record->id = m_threads.size() - 1;
+      }
+      return *record;
+   }
+
+   //! Seconds since the registry was created.
+   inline auto now() const -> double {
+      return m_clock.elapsed_time();
+   }
+
+   inline auto tracing() const -> bool {
+      return INSTRUMENTATION && !m_trace_file.empty();
+   }
+
+   inline auto print_counters() const -> bool {
+      return INSTRUMENTATION && m_print_counters;
+   }
+
+   //! Sum of the counters of all threads.
+   inline auto counters() -> CounterValues {
+      CounterValues totals {};
+      std::lock_guard<std::mutex> lock(m_mutex);
+      for (const std::unique_ptr<ThreadRecord>& thread : m_threads) {
+         for (std::size_t c = 0; c < COUNTERS; ++c) {
+            totals[c] += thread->counters[c].load(std::memory_order_relaxed);
+         }
+      }
+      return totals;
+   }
+
+   //! Phases of all threads, merged by name.
+   inline auto phases() -> std::vector<PhaseTotal> {
+      std::map<std::string, PhaseTotal> merged;
+      std::lock_guard<std::mutex> lock(m_mutex);
+      for (const std::unique_ptr<ThreadRecord>& thread : m_threads) {
+         for (const auto& [name, phase] : thread->phases) {
+            PhaseTotal& total = merged[phase.name];
+            total.name = phase.name;
+            total.seconds += phase.seconds;
+            total.calls += phase.calls;
+         }
+      }
+
+      std::vector<PhaseTotal> phases;
+      for (auto& [name, phase] : merged) {
+         phases.push_back(std::move(phase));
+      }
+      return phases;
+   }
+
+   //! Zero the counters and drop the phases of all threads.
+   inline auto reset() -> void {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      for (const std::unique_ptr<ThreadRecord>& thread : m_threads) {
+         for (std::atomic<std::uint64_t>& counter : thread->counters) {
+            counter.store(0, std::memory_order_relaxed);
+         }
+         thread->phases.clear();
+         thread->events.clear();
+      }
+   }
+
+   inline auto print_report(std::ostream& out) -> void {
+      if constexpr (!INSTRUMENTATION) {
+         std::println(out, "Instrumentation is disabled in this build.");
+         return;
+      }
+
+      std::println(out, "Performance counters:");
+      const CounterValues totals = counters();
+      for (std::size_t c = 0; c < COUNTERS; ++c) {
+         std::println(out, "   {:<24}{}", COUNTER_NAMES[c], totals[c]);
+      }
+
+      std::println(out, "Phases (calls, seconds summed over all threads):");
+      for (const PhaseTotal& phase : phases()) {
+         std::println(
+              out, "   {:<24}{:>10} {:>12.6f}", phase.name, phase.calls,
+              phase.seconds);
+      }
+   }
+
+   //! Write the phases of all threads as complete events ("X") of the
+   //! Chrome trace event format, one track per thread.
+   inline auto write_trace(std::ostream& out) -> void {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      std::print(out, "{{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+      bool first = true;
+      const auto separate = [&]() {
+         std::print(out, "{}\n", first ? "" : ",");
+         first = false;
+      };
+
+      for (const std::unique_ptr<ThreadRecord>& thread : m_threads) {
+         separate();
+         std::print(
+              out,
+              "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,"
+              "\"tid\":{0},\"args\":{{\"name\":\"thread {0}\"}}}}",
+              thread->id);
+         for (const TraceEvent& event : thread->events) {
+            separate();
+            std::print(
+                 out,
+                 "{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":0,\"tid\":{},"
+                 "\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                 event.name, thread->id, event.start * 1e6,
+                 event.duration * 1e6);
+         }
+      }
+      std::println(out, "\n]}}");
+   }
+
+   //! Write the trace to the trace_file (if any) and print the counters if
+   //! requested. Throws if the trace file cannot be written.
+   inline auto finish(std::ostream& out) -> void {
+      if (print_counters()) {
+         print_report(out);
+      }
+      if (!tracing()) {
+         return;
+      }
+
+      std::ofstream trace(m_trace_file);
+      write_trace(trace);
+      trace.close();
+      if (!trace) {
+         throw std::runtime_error("Failed to write " + m_trace_file);
+      }
+   }
+
+ private:
+   std::string m_trace_file {};
+   bool m_print_counters {false};
+
+   Timer m_clock {};
+   std::mutex m_mutex {};
+   std::vector<std::unique_ptr<ThreadRecord>> m_threads {};
+};
+
+//! Registry of the process.
+inline auto instrumentation() -> Instrumentation& {
+   static Instrumentation registry;
+   return registry;
+}
+
+//! Add to a counter of the calling thread.
+inline auto count(const Counter counter, const std::uint64_t amount = 1)
+     -> void {
+   if constexpr (INSTRUMENTATION) {
+      // Only the owning thread writes, no read-modify-write needed
+      std::atomic<std::uint64_t>& c = instrumentation().local().counters[
+           static_cast<std::size_t>(counter)];
+      c.store(c.load(std::memory_order_relaxed) + amount,
+              std::memory_order_relaxed);
+   }
+}
+
+/******************************************************************************
+ * @brief Times the scope as a phase of the calling thread.
+ *
+ * The name has to be a string literal. The phase is traced as well if a
+ * trace_file is set.
+ ******************************************************************************/
+class ScopedPhase {
+ public:
+   explicit ScopedPhase(const char* name) : m_name {name} {
+      if constexpr (INSTRUMENTATION) {
+         m_start = instrumentation().now();
+      }
+   }
+
+   ScopedPhase(const ScopedPhase&) = delete;
+   auto operator=(const ScopedPhase&) -> ScopedPhase& = delete;
+
+   ~ScopedPhase() {
+      if constexpr (INSTRUMENTATION) {
+         Instrumentation& registry = instrumentation();
+         const double duration = registry.now() - m_start;
+         Instrumentation::ThreadRecord& record = registry.local();
+
+         auto it = record.phases.begin();
+         while (it != record.phases.end() && it->first != m_name) {
+            ++it;
+         }
+         if (it == record.phases.end()) {
+            record.phases.push_back({m_name, {.name = m_name}});
+            it = record.phases.end() - 1;
+         }
+         it->second.seconds += duration;
+         ++it->second.calls;
+
+         if (registry.tracing() &&
+             record.events.size() < Instrumentation::MAX_TRACE_EVENTS) {
+            record.events.push_back(
+                 {.name = m_name, .start = m_start, .duration = duration});
+         }
+      }
+   }
+
+ private:
+   const char* m_name;
+   double m_start {0};
+};
+
+/******************************************************************************
+ * @brief Thread that spawned a task, to count the tasks that are stolen.
+ *
+ * Create it with spawn() right before the task and pass it firstprivate,
+ * the task calls started() first.
+ ******************************************************************************/
+class TaskOrigin {
+ public:
+   inline static auto spawn() -> TaskOrigin {
+      TaskOrigin origin {};
+      if constexpr (INSTRUMENTATION) {
+         Instrumentation::ThreadRecord& record = instrumentation().local();
+         origin.m_thread = record.id;
+         count(Counter::TASKS_SPAWNED);
+      }
+      return origin;
+   }
+
+   inline auto started() const -> void {
+      if constexpr (INSTRUMENTATION) {
+         if (instrumentation().local().id != m_thread) {
+            count(Counter::TASKS_STOLEN);
+         }
+      }
+   }
+
+ private:
+   std::size_t m_thread {0};
+};
+
+}  // end namespace jcdp::util
+
+// >>>>>>>>>>>>>>>> INCLUDE TEMPLATE AND INLINE DEFINITIONS <<<<<<<<<<<<<<<<< //
+
+#endif  // JCDP_UTIL_INSTRUMENTATION_HPP_
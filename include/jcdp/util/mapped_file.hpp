@@ -0,0 +1,117 @@
+/******************************************************************************
+ * @file jcdp/util/mapped_file.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides a read-only
+ *        memory mapping of a file.
+ ******************************************************************************/
+
+#ifndef JCDP_UTIL_MAPPED_FILE_HPP_
+#define JCDP_UTIL_MAPPED_FILE_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <system_error>
+#include <utility>
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::util {
+
+/******************************************************************************
+ * @brief Contents of a file, paged in by the OS on first access.
+ *
+ * Nothing is read upfront, so opening is independent of the file size.
+ ******************************************************************************/
+class MappedFile {
+ public:
+   MappedFile() = default;
+
+   //! Throws a std::system_error if the file cannot be mapped.
+   explicit MappedFile(const std::filesystem::path& path) {
+      const int fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0) {
+         throw std::system_error(
+              errno, std::generic_category(),
+              "Failed to open " + path.string());
+      }
+
+      struct stat st {};
+      if (::fstat(fd, &st) != 0) {
+         const int error = errno;
+         ::close(fd);
+         throw std::system_error(
+              error, std::generic_category(),
+              "Failed to stat " + path.string());
+      }
+
+      m_size = static_cast<std::size_t>(st.st_size);
+      if (m_size > 0) {
+         void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+         if (data == MAP_FAILED) {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error(
+                 error, std::generic_category(),
+                 "Failed to map " + path.string());
+         }
+         m_data = static_cast<const std::byte*>(data);
+      }
+      // The mapping stays valid without the descriptor
+      ::close(fd);
+   }
+
+   MappedFile(const MappedFile&) = delete;
+   auto operator=(const MappedFile&) -> MappedFile& = delete;
+
+   MappedFile(MappedFile&& other) noexcept
+      : m_data {std::exchange(other.m_data, nullptr)},
+        m_size {std::exchange(other.m_size, 0)} {}
+
+   auto operator=(MappedFile&& other) noexcept -> MappedFile& {
+      if (this != &other) {
+         unmap();
+         m_data = std::exchange(other.m_data, nullptr);
+         m_size = std::exchange(other.m_size, 0);
+      }
+      return *this;
+   }
+
+   ~MappedFile() {
+      unmap();
+   }
+
+   inline auto bytes() const -> std::span<const std::byte> {
+      return {m_data, m_size};
+   }
+
+   inline auto size() const -> std::size_t {
+      return m_size;
+   }
+
+ private:
+   const std::byte* m_data {nullptr};
+   std::size_t m_size {0};
+
+   inline auto unmap() -> void {
+      if (m_data) {
+         ::munmap(const_cast<std::byte*>(m_data), m_size);
+      }
+      m_data = nullptr;
+      m_size = 0;
+   }
+};
+
+}  // end namespace jcdp::util
+
+// >>>>>>>>>>>>>>>> INCLUDE TEMPLATE AND INLINE DEFINITIONS <<<<<<<<<<<<<<<<< //
+
+#endif  // JCDP_UTIL_MAPPED_FILE_HPP_
@@ -0,0 +1,98 @@
+/******************************************************************************
+ * @file jcdp/util/object_pool.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides a pool of
+ *        recyclable objects with one free list per OpenMP thread.
+ ******************************************************************************/
+
+#ifndef JCDP_UTIL_OBJECT_POOL_HPP_
+#define JCDP_UTIL_OBJECT_POOL_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "jcdp/util/thread_num.hpp"
+
+#include "omp.h"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::util {
+
+/******************************************************************************
+ * @brief Pool of objects whose storage is reused instead of freed.
+ *
+ * acquire() copy-assigns into a previously released object, so containers
+ * inside of T keep their capacity and copying usually doesn't allocate.
+ * Objects may be released by a different thread than the one that acquired
+ * them, they just move to the free list of the releasing thread. Every
+ * thread only ever touches its own free list, so no locking is needed.
+ *
+ * @tparam T Copy-assignable type of the pooled objects.
+ ******************************************************************************/
+template<typename T>
+class ObjectPool {
+ public:
+   ObjectPool() = default;
+
+   ObjectPool(const ObjectPool&) = delete;
+   auto operator=(const ObjectPool&) -> ObjectPool& = delete;
+
+   //! Provide free lists for the given amount of threads, and for the
+   //! calling one (see active_thread_num()). Not thread-safe.
+   inline auto resize(std::size_t threads = omp_get_max_threads()) -> void {
+      if (const std::optional<std::size_t> thread = active_thread_num()) {
+         threads = std::max(threads, *thread + 1);
+      }
+      if (threads > m_free_lists.size()) {
+         m_free_lists.resize(threads);
+      }
+   }
+
+   //! Copy of value that has to be handed back with release().
+   inline auto acquire(const T& value) -> T* {
+      std::vector<std::unique_ptr<T>>* free = free_list();
+      if (!free || free->empty()) {
+         return new T(value);
+      }
+
+      T* obj = free->back().release();
+      free->pop_back();
+      *obj = value;
+      return obj;
+   }
+
+   inline auto release(T* obj) -> void {
+      std::vector<std::unique_ptr<T>>* free = free_list();
+      if (!free) {
+         delete obj;
+         return;
+      }
+      free->emplace_back(obj);
+   }
+
+ private:
+   //! Padded to avoid false sharing between the free lists.
+   struct alignas(64) FreeList {
+      std::vector<std::unique_ptr<T>> objects {};
+   };
+
+   std::vector<FreeList> m_free_lists {};
+
+   inline auto free_list() -> std::vector<std::unique_ptr<T>>* {
+      const std::optional<std::size_t> thread = active_thread_num();
+      if (!thread || *thread >= m_free_lists.size()) {
+         return nullptr;
+      }
+      return &m_free_lists[*thread].objects;
+   }
+};
+
+}  // end namespace jcdp::util
+
+#endif  // JCDP_UTIL_OBJECT_POOL_HPP_
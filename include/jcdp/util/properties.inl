@@ -20,6 +20,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -131,7 +132,11 @@ inline auto PropertyInfo<std::vector<T>>::from_pipe(std::istream& i) -> void {
 //! Return the value as a string.
 template<typename T>
 inline auto PropertyInfo<T>::to_string() const -> const std::string {
-   return std::to_string(*(this->m_ptr));
+   if constexpr (std::is_same_v<T, std::string>) {
+      return *(this->m_ptr);
+   } else {
+      return std::to_string(*(this->m_ptr));
+   }
 }
 
 template<typename T1, typename T2>
@@ -0,0 +1,141 @@
+/******************************************************************************
+ * @file jcdp/util/record_writer.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides a binary format
+ *        of fixed-width records, e.g. for the results of jcdp_batch, that is
+ *        cheaper to write and to read than CSV.
+ ******************************************************************************/
+
+#ifndef JCDP_UTIL_RECORD_WRITER_HPP_
+#define JCDP_UTIL_RECORD_WRITER_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::util {
+
+enum class ColumnType : std::uint8_t {
+   UINT64 = 0,
+   FLOAT64 = 1,
+   BOOL = 2
+};
+
+inline constexpr auto column_width(const ColumnType type) -> std::size_t {
+   return type == ColumnType::BOOL ? 1 : 8;
+}
+
+struct Column {
+   std::string name {};
+   ColumnType type {ColumnType::UINT64};
+};
+
+/******************************************************************************
+ * @brief Columns of the records of a file.
+ *
+ * The file starts with the header written by write_header():
+ *
+ *   char[8]  magic "JCDPREC\0"
+ *   u32      version
+ *   u32      amount of columns
+ *   u64      record size in bytes
+ *   per column: u8 type, u32 name length, name (without terminator)
+ *
+ * followed by the records until the end of the file. A record holds the
+ * values of all columns in order, without any padding. All integers are
+ * little endian, doubles are IEEE 754 and booleans are a single byte.
+ ******************************************************************************/
+class RecordSchema {
+ public:
+   static constexpr char MAGIC[8] = {'J', 'C', 'D', 'P', 'R', 'E', 'C', '\0'};
+   static constexpr std::uint32_t VERSION = 1;
+
+   inline auto add(std::string name, const ColumnType type) -> void {
+      m_record_size += column_width(type);
+      m_columns.push_back({.name = std::move(name), .type = type});
+   }
+
+   inline auto columns() const -> const std::vector<Column>& {
+      return m_columns;
+   }
+
+   inline auto record_size() const -> std::size_t {
+      return m_record_size;
+   }
+
+   inline auto write_header(std::ostream& out) const -> void {
+      std::string header(MAGIC, sizeof(MAGIC));
+      put_le(header, VERSION, 4);
+      put_le(header, m_columns.size(), 4);
+      put_le(header, m_record_size, 8);
+      for (const Column& column : m_columns) {
+         header.push_back(static_cast<char>(column.type));
+         put_le(header, column.name.size(), 4);
+         header += column.name;
+      }
+      out.write(header.data(), static_cast<std::streamsize>(header.size()));
+   }
+
+   //! Append the lowest bytes of value, least significant first.
+   inline static auto put_le(
+        std::string& bytes, const std::uint64_t value, const std::size_t width)
+        -> void {
+      for (std::size_t b = 0; b < width; ++b) {
+         bytes.push_back(static_cast<char>((value >> (8 * b)) & 0xFF));
+      }
+   }
+
+ private:
+   std::vector<Column> m_columns {};
+   std::size_t m_record_size {0};
+};
+
+/******************************************************************************
+ * @brief Encoded values of consecutive columns of a record.
+ *
+ * The values have to be added in the order (and with the types) of the
+ * columns in the schema. Complete records can be concatenated from the
+ * fields of several parts, e.g. as the parts of a ReorderBuffer.
+ ******************************************************************************/
+class RecordFields {
+ public:
+   inline auto add(const std::uint64_t value) -> RecordFields& {
+      RecordSchema::put_le(m_bytes, value, 8);
+      return *this;
+   }
+
+   inline auto add(const double value) -> RecordFields& {
+      RecordSchema::put_le(m_bytes, std::bit_cast<std::uint64_t>(value), 8);
+      return *this;
+   }
+
+   inline auto add(const bool value) -> RecordFields& {
+      m_bytes.push_back(static_cast<char>(value));
+      return *this;
+   }
+
+   inline auto size() const -> std::size_t {
+      return m_bytes.size();
+   }
+
+   inline auto bytes() && -> std::string {
+      return std::move(m_bytes);
+   }
+
+ private:
+   std::string m_bytes {};
+};
+
+}  // end namespace jcdp::util
+
+// >>>>>>>>>>>>>>>> INCLUDE TEMPLATE AND INLINE DEFINITIONS <<<<<<<<<<<<<<<<< //
+
+#endif  // JCDP_UTIL_RECORD_WRITER_HPP_
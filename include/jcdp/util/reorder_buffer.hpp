@@ -0,0 +1,101 @@
+/******************************************************************************
+ * @file jcdp/util/reorder_buffer.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides a buffer that
+ *        writes rows, whose parts are computed out of order by concurrent
+ *        jobs, in their original order.
+ ******************************************************************************/
+
+#ifndef JCDP_UTIL_REORDER_BUFFER_HPP_
+#define JCDP_UTIL_REORDER_BUFFER_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <cassert>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::util {
+
+/******************************************************************************
+ * @brief Rows of separated parts that are streamed in order (thread-safe).
+ *
+ * A row is written (and flushed) as soon as all of its parts as well as all
+ * previous rows are complete, so the output is the same as the one of a
+ * sequential run and a canceled run still has all leading rows. Parts are
+ * arbitrary bytes, e.g. binary records with an empty separator and end.
+ ******************************************************************************/
+class ReorderBuffer {
+ public:
+   ReorderBuffer(
+        std::ostream& out, const std::size_t rows, const std::size_t parts,
+        std::string separator = ",", std::string row_end = "\n")
+      : m_out {out}, m_rows(rows), m_parts {parts},
+        m_separator {std::move(separator)}, m_row_end {std::move(row_end)} {
+      for (Row& row : m_rows) {
+         row.parts.resize(parts);
+      }
+   }
+
+   ReorderBuffer(const ReorderBuffer&) = delete;
+   auto operator=(const ReorderBuffer&) -> ReorderBuffer& = delete;
+
+   inline auto put(
+        const std::size_t row, const std::size_t part, std::string value)
+        -> void {
+      assert(row < m_rows.size() && part < m_parts);
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      Row& r = m_rows[row];
+      r.parts[part] = std::move(value);
+      ++r.done;
+
+      bool flush = false;
+      for (; m_next < m_rows.size() && m_rows[m_next].done == m_parts;
+           ++m_next) {
+         Row& next = m_rows[m_next];
+         for (std::size_t p = 0; p < m_parts; ++p) {
+            m_out << next.parts[p] << (p + 1 < m_parts ? m_separator
+                                                       : m_row_end);
+         }
+         next.parts = {};
+         flush = true;
+      }
+      if (flush) {
+         m_out.flush();
+      }
+   }
+
+   //! Whether all rows were written.
+   inline auto complete() -> bool {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_next == m_rows.size();
+   }
+
+ private:
+   struct Row {
+      std::vector<std::string> parts {};
+      std::size_t done {0};
+   };
+
+   std::ostream& m_out;
+   std::vector<Row> m_rows;
+   std::size_t m_parts;
+   std::string m_separator;
+   std::string m_row_end;
+
+   std::mutex m_mutex {};
+   std::size_t m_next {0};
+};
+
+}  // end namespace jcdp::util
+
+// >>>>>>>>>>>>>>>> INCLUDE TEMPLATE AND INLINE DEFINITIONS <<<<<<<<<<<<<<<<< //
+
+#endif  // JCDP_UTIL_REORDER_BUFFER_HPP_
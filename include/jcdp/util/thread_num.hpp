@@ -0,0 +1,42 @@
+/******************************************************************************
+ * @file jcdp/util/thread_num.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides the index of the
+ *        calling thread that the per-thread buffers are looked up with.
+ ******************************************************************************/
+
+#ifndef JCDP_UTIL_THREAD_NUM_HPP_
+#define JCDP_UTIL_THREAD_NUM_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <cstddef>
+#include <optional>
+
+#include "omp.h"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::util {
+
+//! Index of the calling thread in the only active team, if there is at most
+//! one. Threads of inactive nested regions (e.g. a solver called by a batch
+//! thread) are identified by their ancestor in the active team.
+inline auto active_thread_num() -> std::optional<std::size_t> {
+   if (omp_get_active_level() > 1) {
+      return {};
+   }
+
+   for (int level = omp_get_level(); level > 0; --level) {
+      if (omp_get_team_size(level) > 1) {
+         return omp_get_ancestor_thread_num(level);
+      }
+   }
+   return 0;
+}
+
+}  // end namespace jcdp::util
+
+// >>>>>>>>>>>>>>>> INCLUDE TEMPLATE AND INLINE DEFINITIONS <<<<<<<<<<<<<<<<< //
+
+#endif  // JCDP_UTIL_THREAD_NUM_HPP_
@@ -51,6 +51,11 @@ class Timer {
       return rem;
    }
 
+   //! Seconds since the timer was started.
+   inline auto elapsed_time() const -> double {
+      return std::chrono::duration<double>(timer_t::now() - m_start).count();
+   }
+
    inline auto finished_in_time() const -> bool {
       return !m_timer_expired;
    }
@@ -0,0 +1,112 @@
+/******************************************************************************
+ * @file jcdp/workspace.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides scratch buffers
+ *        that are reused by the schedulers across many calls, so that batch
+ *        runs over many small chains don't spend their time in the allocator.
+ ******************************************************************************/
+
+#ifndef JCDP_WORKSPACE_HPP_
+#define JCDP_WORKSPACE_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "jcdp/scheduler/transposition_table.hpp"
+#include "jcdp/sequence.hpp"
+#include "jcdp/util/thread_num.hpp"
+
+#include "omp.h"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp {
+
+/******************************************************************************
+ * @brief Per OpenMP thread scratch buffers.
+ *
+ * The buffers are only ever resized (never shrunk), so after the first chain
+ * of the maximal length no further allocations happen. Each OpenMP thread
+ * gets its own set, which is safe as long as the user (e.g. a scheduler)
+ * doesn't hit a task scheduling point while it holds on to them.
+ ******************************************************************************/
+class Workspace {
+ public:
+   struct Local {
+      Sequence sequence {};
+      std::vector<std::size_t> thread_loads {};
+      std::vector<std::size_t> indices {};
+
+      //! Per operation levels and ready times, threads ordered by their
+      //! load (priority list scheduler)
+      std::vector<std::size_t> levels {};
+      std::vector<std::size_t> ready_times {};
+      std::vector<std::size_t> threads_by_load {};
+
+      //! Per operation data and orders of the scheduler lower bounds
+      std::vector<std::size_t> tails {};
+      std::vector<std::size_t> finish_times {};
+      std::vector<std::size_t> by_tail {};
+      std::vector<std::size_t> by_fma {};
+      std::vector<std::size_t> sorted_loads {};
+
+      //! Visited states of the branch & bound scheduler
+      scheduler::TranspositionTable table {};
+      std::vector<std::size_t> state {};
+   };
+
+   Workspace() = default;
+
+   Workspace(const Workspace&) = delete;
+   auto operator=(const Workspace&) -> Workspace& = delete;
+
+   //! Pre-size the buffers for chains of up to max_length Jacobians.
+   inline auto reserve(
+        const std::size_t max_length,
+        const std::size_t threads = omp_get_max_threads()) -> void {
+      m_max_length = std::max(m_max_length, max_length);
+
+      // Upper bound for longest_possible_sequence() of such a chain
+      const std::size_t max_ops = 2 * m_max_length;
+      m_locals.resize(std::max(m_locals.size(), threads));
+      for (Local& local : m_locals) {
+         local.sequence.reserve(max_ops);
+         local.thread_loads.reserve(m_max_length);
+         local.indices.reserve(max_ops);
+         local.levels.reserve(max_ops);
+         local.ready_times.reserve(max_ops);
+         local.threads_by_load.reserve(m_max_length);
+         local.tails.reserve(max_ops);
+         local.finish_times.reserve(max_ops);
+         local.by_tail.reserve(max_ops);
+         local.by_fma.reserve(max_ops);
+         local.sorted_loads.reserve(m_max_length);
+         local.state.reserve(max_ops + m_max_length + 1);
+      }
+   }
+
+   inline auto max_length() const -> std::size_t {
+      return m_max_length;
+   }
+
+   //! Buffers of the calling OpenMP thread, nullptr if it has none.
+   inline auto local() -> Local* {
+      const std::optional<std::size_t> thread = util::active_thread_num();
+      if (!thread || *thread >= m_locals.size()) {
+         return nullptr;
+      }
+      return &m_locals[*thread];
+   }
+
+ private:
+   std::size_t m_max_length {0};
+   std::vector<Local> m_locals {};
+};
+
+}  // end namespace jcdp
+
+#endif  // JCDP_WORKSPACE_HPP_
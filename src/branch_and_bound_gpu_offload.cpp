@@ -1,275 +1,1074 @@
 #include <algorithm>
+#include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <array>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <utility>
+#include <vector>
 
 #include <omp.h>
 
 #include "jcdp/operation.hpp"
+#include "jcdp/packed_operation.hpp"
 #include "jcdp/scheduler/scheduler.hpp"
 #include "jcdp/sequence.hpp"
 #include "jcdp/deviceSequence.hpp"
+#include "jcdp/scheduler/branch_and_bound.hpp"
 #include "jcdp/scheduler/branch_and_bound_gpu.hpp"
+#include "jcdp/util/instrumentation.hpp"
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
 namespace jcdp::scheduler {
 
-struct Layer{
+// Decision on one level of the search tree and the state it replaced. This
+// is an undo log: only the load of the chosen thread is saved, not all loads.
+struct Layer {
+   PackedOperation::index_t op_idx = 0;
+   PackedOperation::index_t thread_idx = 0;
+   std::size_t old_thread_load = 0;
+   std::size_t old_idling_time = 0;
+   std::size_t old_makespan = 0;
+};
+
+#pragma omp declare target
+// Partial schedule of the branch & bound search. The private arrays are sized
+// by the template parameters, so that smaller problems use less registers and
+// local memory per device thread.
+template<std::size_t MaxLength, std::size_t MaxThreads>
+struct DeviceSearch {
+   BasicDeviceSequence<MaxLength> working_copy;
+   std::array<std::size_t, MaxThreads> thread_loads;
+   Layer stack_array[MaxLength];
+   std::size_t depth;
+   std::size_t makespan;
+   std::size_t idling_time;
+   std::size_t usable_threads;
+   std::size_t sequential_makespan;
+
+   void init(
+        const PackedOperation* ops, const std::size_t length,
+        const std::size_t threads, const std::size_t sequential) {
+      for (std::size_t i = 0; i < length; ++i) {
+         working_copy.ops[i] = ops[i];
+      }
+      working_copy.length = length;
+      thread_loads.fill(0);
+      depth = 0;
+      makespan = 0;
+      idling_time = 0;
+      usable_threads = threads;
+      sequential_makespan = sequential;
+   }
+
+   // Find the next branch of the current level, starting at (op_idx,
+   // thread_idx). Same order as BranchAndBoundScheduler: all schedulable
+   // operations on all threads, where only the first of several threads
+   // with the same load is tried.
+   bool next_branch(std::size_t& op_idx, std::size_t& thread_idx) const {
+      while (op_idx < working_copy.length) {
+         if (working_copy.ops[op_idx].is_scheduled ||
+             thread_idx >= usable_threads ||
+             !is_schedulable(working_copy, op_idx)) {
+            op_idx++;
+            thread_idx = 0;
+            continue;
+         }
 
-  size_t  op_idx = 0;      
-  size_t  next_op_idx = 0; 
-  size_t  thread_idx  = 0;      
-  size_t  depth = 0;           
-  time_t start_time_op = 0;
-  time_t idletime  = 0;
-  size_t makespan = 0;
+         // Threads with the same load are interchangeable (w.l.o.g.)
+         bool duplicate = false;
+         for (std::size_t t = 0; t < thread_idx; ++t) {
+            duplicate |= (thread_loads[t] == thread_loads[thread_idx]);
+         }
+         if (!duplicate) {
+            return true;
+         }
+         thread_idx++;
+      }
+      return false;
+   }
+
+   // Schedule the operation on the thread and go one level deeper
+   void push(const std::size_t op_idx, const std::size_t thread_idx) {
+      Layer& layer = stack_array[depth++];
+      layer.op_idx = static_cast<PackedOperation::index_t>(op_idx);
+      layer.thread_idx = static_cast<PackedOperation::index_t>(thread_idx);
+      layer.old_thread_load = thread_loads[thread_idx];
+      layer.old_idling_time = idling_time;
+      layer.old_makespan = makespan;
+
+      const std::size_t start_time = std::max(
+           thread_loads[thread_idx], earliest_start(working_copy, op_idx));
+      working_copy.ops[op_idx].is_scheduled = true;
+      working_copy.ops[op_idx].start_time = start_time;
+      working_copy.ops[op_idx].thread = layer.thread_idx;
+      idling_time += (start_time - thread_loads[thread_idx]);
+      thread_loads[thread_idx] = start_time + working_copy.ops[op_idx].fma;
+      makespan = std::max(makespan, thread_loads[thread_idx]);
+   }
 
-  std::array<std::size_t,20> thread_loads_full_array{};      // Value has to be fixed for GPU. Selected smaller value, to reduce size.
+   // Revert the last decision, returns it
+   const Layer& pop() {
+      const Layer& layer = stack_array[--depth];
+      working_copy.ops[layer.op_idx].is_scheduled = false;
+      working_copy.ops[layer.op_idx].start_time = 0;
+      thread_loads[layer.thread_idx] = layer.old_thread_load;
+      idling_time = layer.old_idling_time;
+      makespan = layer.old_makespan;
+      return layer;
+   }
+
+   // Lower bound for all schedules below the current node
+   std::size_t bound() const {
+      const std::size_t lb = std::max(
+           ((idling_time + sequential_makespan) / usable_threads),
+           device_critical_path(working_copy));
+      return std::max(lb, makespan);
+   }
 };
 
-#pragma omp declare target
-static DeviceSequence nonrecursive_schedule_op(std::size_t& best_makespan, DeviceSequence& working_copy, const std::size_t usable_threads,
-const std::size_t sequential_makespan){
-
-         std::array<std::size_t,20> thread_loads{};      // Value has to be fixed for GPU. Selected smaller value, to reduce size.
-         thread_loads.fill(0);
-
-         std::size_t makespan = 0;
-         std::size_t idling_time = 0;
-
-         Layer stack_array[20]; // Value has to be fixed for GPU. Selected smaller value, to reduce size.
-         std::size_t stack_pointer = 0;
-         bool revert_depth = false;
-         bool revert_op_idx = false;
-         bool revert_thread_idx = false;
-         bool skip_changes = false;
-         std::size_t op_idx = 0;
-         std::size_t thread_idx = 0;
-         std::size_t depth = 0;
-         DeviceSequence sequence = working_copy; 
-
-         
-
-         for(std::size_t op_idx_temp = 0; op_idx_temp < working_copy.length; ++op_idx_temp){
-            if (working_copy.ops[op_idx_temp].is_scheduled) {
-               depth++;
-            }
+// Iterative depth-first search (no recursion on the device) below the current
+// node of the search. Nodes at max_depth are handed to leaf(search), which
+// returns true to abort. Branches are pruned against upper_bound(), which may
+// decrease during the search (e.g. if it is shared by several threads).
+// Every visited node takes one of the remaining nodes, returns false if they
+// ran out before the search was done.
+template<std::size_t MaxLength, std::size_t MaxThreads, typename UpperBound,
+         typename Leaf>
+static bool depth_first_search(
+     DeviceSearch<MaxLength, MaxThreads>& search, const std::size_t max_depth,
+     std::size_t& nodes, UpperBound&& upper_bound, Leaf&& leaf) {
+   const std::size_t base_depth = search.depth;
+
+   // Next branch to try on the current level
+   std::size_t op_idx = 0;
+   std::size_t thread_idx = 0;
+
+   while (nodes > 0) {
+      --nodes;
+
+      const bool is_leaf = (search.depth == max_depth);
+      if (is_leaf && leaf(search)) {
+         return true;
+      }
+
+      // All branches of this level are done, revert one level up
+      if (is_leaf || !search.next_branch(op_idx, thread_idx)) {
+         if (search.depth == base_depth) {
+            return true;
          }
+         const Layer& layer = search.pop();
+         op_idx = layer.op_idx;
+         thread_idx = layer.thread_idx + 1;
+         continue;
+      }
 
+      // Check against lower bound and go deeper if possible
+      search.push(op_idx, thread_idx);
+      if (search.bound() < upper_bound()) {
+         op_idx = 0;
+         thread_idx = 0;
+         continue;
+      }
 
-         //create initial layer
-         Layer initial_layer;
-         initial_layer.op_idx = 0;
-         initial_layer.next_op_idx = 0;
-         initial_layer.thread_idx = 0;    
-         initial_layer.depth = depth;
-         initial_layer.start_time_op = working_copy.ops[0].start_time;
-         initial_layer.makespan = makespan;
-         initial_layer.idletime = idling_time;
-         initial_layer.thread_loads_full_array = thread_loads;
-         stack_array[stack_pointer++] = initial_layer;
-
-         int timer_replacement = 0;
-         while(timer_replacement<10000000){  //Rudementary replacement for timer. Could be changed into either input value to binary or some estimation value(some mapping from dp duration to gpu iterations)
-            timer_replacement++;
-
-            if(op_idx >= working_copy.length && depth == 0){
-               return sequence;
-            }
+      // Revert the current changes and try the next thread
+      search.pop();
+      thread_idx++;
+   }
+   return false;
+}
 
-            if(op_idx >= working_copy.length){
-               op_idx = working_copy.length -1;
-            }
+// Exhaustive search on a single device thread. Returns the best schedule that
+// beats best_makespan (in best_makespan_output), see BranchAndBoundScheduler.
+// finished is false if the search ran out of nodes, i.e. the schedule may
+// not be optimal.
+template<std::size_t MaxLength, std::size_t MaxThreads>
+static BasicDeviceSequence<MaxLength> nonrecursive_schedule_op(
+     std::size_t& best_makespan, BasicDeviceSequence<MaxLength>& working_copy,
+     const std::size_t usable_threads, const std::size_t sequential_makespan,
+     std::size_t nodes, bool& finished) {
+   BasicDeviceSequence<MaxLength> sequence = working_copy;
+   const std::size_t lower_bound = device_critical_path(working_copy);
 
-            skip_changes = false;
+   DeviceSearch<MaxLength, MaxThreads> search;
+   search.init(
+        working_copy.ops, working_copy.length, usable_threads,
+        sequential_makespan);
 
-            //Find the next non scheduled and schedulable operation
-            if (working_copy.ops[op_idx].is_scheduled or !is_schedulable(working_copy, op_idx)) {
-               op_idx++;
-               stack_array[stack_pointer - 1].next_op_idx = op_idx;
-               if(op_idx >= sequence.length){
-                  revert_op_idx = true;
-                  skip_changes = true;
-               }else{
-                  continue;
-               }
-            }
+   finished = depth_first_search(
+        search, working_copy.length, nodes,
+        [&]() {
+           return best_makespan;
+        },
+        [&](const DeviceSearch<MaxLength, MaxThreads>& leaf) {
+           // Reached a leaf node, update best_makespan if necessary
+           if (leaf.makespan < best_makespan) {
+              best_makespan = leaf.makespan;
+              for (std::size_t i = 0; i < sequence.length; ++i) {
+                 sequence.ops[i].thread = leaf.working_copy.ops[i].thread;
+                 sequence.ops[i].start_time =
+                      leaf.working_copy.ops[i].start_time;
+                 sequence.ops[i].is_scheduled = true;
+              }
+              sequence.best_makespan_output = best_makespan;
+           }
+           return best_makespan <= lower_bound;
+        });
 
-            if(thread_idx >= usable_threads){
-               revert_thread_idx = true;
-               skip_changes = true;
-            }
+   return sequence;
+}
+// Schedule sequence i of a batch (see BranchAndBoundBatchGPU) on the calling
+// device thread and write the schedule back if it beats the upper bound.
+// fin[i] is cleared if the search ran out of nodes.
+template<std::size_t MaxLength, std::size_t MaxThreads>
+static void schedule_batch_entry(
+     PackedOperation* ops, const std::size_t* offsets, const std::size_t* ut,
+     const std::size_t* sms, std::size_t* ms, std::uint8_t* fin,
+     const std::size_t i, const std::size_t upper_bound,
+     const std::size_t nodes) {
+   BasicDeviceSequence<MaxLength> sequence;
+   sequence.length = offsets[i + 1] - offsets[i];
+   sequence.best_makespan_output = ms[i];
+   for (std::size_t k = 0; k < sequence.length; ++k) {
+      sequence.ops[k] = ops[offsets[i] + k];
+   }
 
-            //Schedule the selected operation on the selected thread 
-            if(!skip_changes){
-               working_copy.ops[op_idx].is_scheduled = true;
-               const std::size_t start_time = std::max(thread_loads[thread_idx],earliest_start(working_copy, op_idx));
-               working_copy.ops[op_idx].start_time = start_time;
-               idling_time += (start_time - thread_loads[thread_idx]);
-               thread_loads[thread_idx] = start_time + working_copy.ops[op_idx].fma;
-               makespan = std::max(makespan, thread_loads[thread_idx]); 
-            }
-            
-            //Reached a leaf node, update best_makestpan if necessary
-            if (depth >= working_copy.length - 1) {
-                  if (makespan < best_makespan) {
-                     best_makespan = makespan;
-                     for (size_t i = 0; i < working_copy.length; ++i) {
-                        sequence.ops[i].thread = working_copy.ops[i].thread;
-                        sequence.ops[i].start_time = working_copy.ops[i].start_time;
-                        sequence.ops[i].is_scheduled = true;
-                     }
-                     sequence.best_makespan_output = best_makespan;
-                  }
-                  revert_thread_idx = true;
-            } 
-            
-            //Check against lower bound and go deeper if possible
-            if(!skip_changes && depth < working_copy.length - 1){
-                  const std::size_t lb = std::max(((idling_time + sequential_makespan) / usable_threads),device_critical_path(working_copy));
-                  if (std::max(lb, makespan) < best_makespan) {
-                     working_copy.ops[op_idx].thread = thread_idx;
-                     Layer current_layer;
-                     current_layer.op_idx = op_idx;
-                     current_layer.next_op_idx = 0;
-                     current_layer.thread_idx = thread_idx;
-                     current_layer.depth = depth++;
-                     current_layer.start_time_op = working_copy.ops[op_idx].start_time;
-                     current_layer.makespan = makespan;
-                     current_layer.idletime = idling_time;
-                     current_layer.thread_loads_full_array = thread_loads;   
-                     stack_array[stack_pointer++] = current_layer;
-                     op_idx=0;
-                     thread_idx=0; 
-                  }else{
-                     revert_thread_idx = true;
-                  }
-            }
+   bool finished = true;
+   const BasicDeviceSequence<MaxLength> result =
+        nonrecursive_schedule_op<MaxLength, MaxThreads>(
+             ms[i], sequence, ut[i], sms[i], nodes, finished);
+   fin[i] = finished;
+   if (ms[i] < upper_bound) {
+      for (std::size_t k = 0; k < result.length; ++k) {
+         ops[offsets[i] + k] = result.ops[k];
+      }
+   }
+}
+#pragma omp end declare target
 
-            //Revert the current changes and prepare for next iteration to try with next thread
-            if(revert_thread_idx){
-               revert_thread_idx = false;
-               Layer previous_state = stack_array[stack_pointer -1];
-               if(op_idx < working_copy.length){
-                  working_copy.ops[op_idx].start_time = 0;
-                  working_copy.ops[op_idx].is_scheduled = false;
-               }
-               makespan = previous_state.makespan;
-               idling_time = previous_state.idletime;
-               thread_idx = thread_idx + 1;
-               //if thread overflow, then next operation should be scheduled
-               if(thread_idx >= usable_threads){
-                  revert_op_idx = true;
-               }
-               thread_loads = previous_state.thread_loads_full_array; 
-            }
+// Count a launch of a sequence or batch on the device, which maps buffers of
+// the given size.
+static auto count_offload(const std::size_t bytes) -> void {
+   util::count(util::Counter::GPU_OFFLOADS);
+   util::count(util::Counter::GPU_BYTES_MAPPED, bytes);
+}
 
+// Calls kernel.template operator()<MaxLength, MaxThreads>() with the smallest
+// capacities the kernel is compiled for that fit length and threads.
+template<typename Kernel>
+static auto dispatch_capacity(
+     const std::size_t length, const std::size_t threads, Kernel&& kernel) {
+   assert(length <= MAX_SEQUENCE_LENGTH && threads <= MAX_DEVICE_THREADS);
 
-            //Revert the current changes and prepare for next iteration to try with next operation
-            if(revert_op_idx ){
-               revert_op_idx = false;
-               Layer& previous_state = stack_array[stack_pointer - 1];
-               if(op_idx < working_copy.length){
-                  working_copy.ops[op_idx].start_time = 0;
-                  working_copy.ops[op_idx].is_scheduled = false;  
-                  previous_state.next_op_idx = previous_state.next_op_idx + 1;
-               }
-               op_idx = previous_state.next_op_idx;
-               thread_idx = 0;
-               makespan = previous_state.makespan;
-               idling_time = previous_state.idletime;
-               if(stack_pointer>0){
-                  thread_loads = stack_array[stack_pointer -1].thread_loads_full_array;
-               }
-               //if operation overflow, then revert one level up in the search tree
-               if(op_idx >= working_copy.length){
-                  revert_depth = true;
-               }
-            }
+   const auto for_length = [&]<std::size_t MaxLength>() {
+      if (threads <= 8) {
+         return kernel.template operator()<MaxLength, 8>();
+      }
+      return kernel.template operator()<MaxLength, MAX_DEVICE_THREADS>();
+   };
 
-            //Revert the operation one level up in the search tree and continue with next thread
-            if(revert_depth){
-               revert_depth = false;
-               //if depth is zero, then we are done with all possibilities
-               if(depth == 0){           
-                  return sequence;
-               }
-               depth--;
-               size_t old_idx = stack_array[stack_pointer-1].op_idx;
-               working_copy.ops[old_idx].is_scheduled = false;  
-               working_copy.ops[old_idx].start_time = 0; 
-               stack_pointer--;
-               Layer previous_state = stack_array[stack_pointer -1];
-               op_idx = previous_state.op_idx;
-               thread_idx = previous_state.thread_idx + 1;
-               makespan = previous_state.makespan;
-               idling_time = previous_state.idletime;
-               thread_loads = previous_state.thread_loads_full_array;
+   if (length <= 16) {
+      return for_length.template operator()<16>();
+   }
+   if (length <= 32) {
+      return for_length.template operator()<32>();
+   }
+   return for_length.template operator()<MAX_SEQUENCE_LENGTH>();
+}
 
-            }
+// Schedule a single sequence on the device, searching at most `nodes` nodes.
+// Returns false if the target region was executed on the host.
+template<std::size_t MaxLength, std::size_t MaxThreads>
+static auto offload_schedule(
+     Sequence& sequence, const std::size_t usable_threads,
+     std::size_t& best_makespan, const std::size_t nodes, bool& finished)
+     -> bool {
+      const std::size_t sequential_makespan = sequence.sequential_makespan();
+
+      //Change to gpu compatible version of Sequence
+      BasicDeviceSequence<MaxLength> result_sequence;
+      BasicDeviceSequence<MaxLength> device_working_copy;
+
+      for (std::size_t i = 0; i < sequence.length(); ++i) {
+         device_working_copy.ops[i] = PackedOperation(sequence[i]);
+         // Reset potential previous schedule
+         device_working_copy.ops[i].is_scheduled = false;
+         device_working_copy.ops[i].start_time = 0;
+      }
+      device_working_copy.length = sequence.length();
+      device_working_copy.best_makespan_output = best_makespan;
+
+      //run code on GPU
+      const util::ScopedPhase phase("gpu_offload");
+      count_offload(2 * sizeof(BasicDeviceSequence<MaxLength>));
+      bool notrangpu = false;
+      #pragma omp target map(to: best_makespan, device_working_copy)            \
+                         map(to: usable_threads, sequential_makespan, nodes)   \
+                         map(from: result_sequence)                            \
+                         map(tofrom: notrangpu, finished)
+      {
+         notrangpu = !omp_is_initial_device();
+         if (notrangpu) {
+            result_sequence = nonrecursive_schedule_op<MaxLength, MaxThreads>(
+                 best_makespan, device_working_copy, usable_threads,
+                 sequential_makespan, nodes, finished);
+         }
+      }
 
+      //Catch if gpu offload failed
+      if (!notrangpu) {
+         return false;
+      }
+
+      if (result_sequence.best_makespan_output < best_makespan) {
+         best_makespan = result_sequence.best_makespan_output;
+         for (std::size_t i = 0; i < sequence.length(); ++i) {
+            sequence[i].thread = result_sequence.ops[i].thread;
+            sequence[i].start_time = result_sequence.ops[i].start_time;
+            sequence[i].is_scheduled = true;
          }
-         return sequence;
-};
-#pragma omp end declare target
+      }
+      return true;
+   }
 
 auto BranchAndBoundSchedulerGPU::schedule_impl(
         Sequence& sequence, const std::size_t usable_threads,
-        const std::size_t upper_bound) -> std::size_t {
-         
-      std::size_t sequential_makespan = sequence.sequential_makespan();
-         
-      Sequence working_copy = sequence;
+        const std::size_t upper_bound, const Incumbent* incumbent)
+        -> std::size_t {
       std::size_t best_makespan = upper_bound;
 
-      // Reset potential previous schedule
-      for (Operation& op : working_copy) {
-         op.is_scheduled = false;
-      }
-
-      const std::size_t lower_bound = working_copy.critical_path();
+      const std::size_t lower_bound = sequence.critical_path();
 
       if (lower_bound >= upper_bound) {
          return lower_bound;
       }
 
-      std::vector<std::size_t> accumulation_indices;
-      accumulation_indices.reserve(sequence.length());
-      for (std::size_t idx = 0; idx < sequence.length(); ++idx) {
-         if (sequence[idx].action == Action::ACCUMULATION) {
-            accumulation_indices.push_back(idx);
+      // Doesn't fit into the largest device buffers, schedule on the host
+      if (!BranchAndBoundBatchGPU::fits(sequence, usable_threads)) {
+         BranchAndBoundScheduler host_scheduler;
+         host_scheduler.set_workspace(workspace_ptr());
+         host_scheduler.set_timer(remaining_time());
+         host_scheduler.start_timer();
+         const std::size_t makespan = host_scheduler.schedule_impl(
+              sequence, usable_threads, upper_bound, incumbent);
+         m_timer_expired |= !host_scheduler.finished_in_time();
+         return makespan;
+      }
+
+      // An unfinished search counts as a timeout, its schedule is valid but
+      // not proven to be optimal
+      const std::size_t nodes = node_budget();
+
+      // Batch of just this sequence. With a split depth, all device threads
+      // search it in parallel.
+      const auto schedule_as_batch = [&]() -> std::size_t {
+         BranchAndBoundBatchGPU batch;
+         batch.set_split_depth(m_split_depth);
+         batch.set_node_budget(nodes);
+         batch.push_back(sequence, usable_threads);
+
+         const BatchScheduleResult result = batch.schedule(upper_bound);
+         if (result.index == 0) {
+            batch.apply_best(sequence);
          }
+         m_timer_expired |= !result.finished;
+         return result.makespan;
+      };
+      if (m_split_depth > 0) {
+         return schedule_as_batch();
       }
 
-      //Change to gpu compatible version of Sequence
-      DeviceSequence result_sequence;
-      DeviceSequence device_working_copy;
+      bool finished = true;
+      const bool ran_on_gpu = dispatch_capacity(
+           sequence.length(), usable_threads,
+           [&]<std::size_t MaxLength, std::size_t MaxThreads>() {
+              return offload_schedule<MaxLength, MaxThreads>(
+                   sequence, usable_threads, best_makespan, nodes, finished);
+           });
 
-      for (std::size_t i = 0; i < working_copy.length(); ++i) {
-         device_working_copy.ops[i] = working_copy[i];
+      // The batch kernel also runs on the host if the offload failed
+      if (!ran_on_gpu) {
+         return schedule_as_batch();
       }
-      device_working_copy.length = working_copy.length();
+      m_timer_expired |= !finished;
+      return best_makespan;
+   }
 
+auto BranchAndBoundSchedulerGPU::submit(
+        const Sequence& sequence, const std::size_t threads,
+        Incumbent& incumbent) -> void {
+      const std::size_t usable = usable_threads(sequence, threads);
+      if (!is_asynchronous() ||
+          !BranchAndBoundBatchGPU::fits(sequence, usable)) {
+         Scheduler::submit(sequence, threads, incumbent);
+         return;
+      }
 
-      //run code on GPU
-      bool notrangpu = false;
-      #pragma omp target map(to: best_makespan,device_working_copy,usable_threads,sequential_makespan) map(from: result_sequence) map(tofrom :notrangpu)
+      Stage* full = nullptr;
       {
+         std::lock_guard<std::mutex> lock(m_pipeline_mutex);
+         if (m_pool.empty()) {
+            m_pool = pool_devices(m_devices);
+            m_stages.resize(m_pool.size() + 1);
+            m_device_busy.assign(m_pool.size(), false);
+            m_filling = 0;
+         }
+
+         Stage& stage = m_stages[m_filling];
+         stage.batch.push_back(sequence, usable);
+         stage.sequences.push_back(sequence);
+
+         // Keep filling this stage while all devices are busy. Otherwise
+         // there is a free stage as well, at most one per device is in flight
+         const auto idle = std::ranges::find(m_device_busy, false);
+         if (stage.batch.size() >= m_pipeline_batch &&
+             idle != m_device_busy.end()) {
+            stage.in_flight = true;
+            stage.slot = idle - m_device_busy.begin();
+            *idle = true;
+
+            m_filling = std::ranges::find_if(m_stages, [](const Stage& s) {
+                           return !s.in_flight;
+                        }) - m_stages.begin();
+            assert(m_filling < m_stages.size());
+            full = &stage;
+         }
+      }
+
+      // Outside of the lock, included tasks may complete the batch right away
+      if (full) {
+         launch_stage(*full, incumbent);
+      }
+   }
+
+auto BranchAndBoundSchedulerGPU::wait(Incumbent& incumbent) -> void {
+      // The batches in flight are completed by tasks of the submitting
+      // threads, the caller waits for those (e.g. with a taskgroup)
+      assert(std::ranges::none_of(m_stages, &Stage::in_flight));
+
+      if (m_pool.empty()) {
+         return;
+      }
+
+      Stage& stage = m_stages[m_filling];
+      if (stage.batch.size() > 0) {
+         stage.in_flight = true;
+         stage.slot = 0;
+         m_device_busy[0] = true;
+         launch_stage(stage, incumbent);
+         #pragma omp taskwait
+      }
+
+      // The next submit() picks up changes of the device count
+      m_pool.clear();
+   }
 
-        notrangpu = !omp_is_initial_device();
-        if(notrangpu){
-            result_sequence = nonrecursive_schedule_op(best_makespan, device_working_copy, usable_threads, sequential_makespan);  
-        }
-      } 
+auto BranchAndBoundSchedulerGPU::launch_stage(
+        Stage& stage, Incumbent& incumbent) -> void {
+      stage.batch.set_split_depth(m_split_depth);
+      stage.batch.set_node_budget(node_budget());
+      stage.batch.set_device(m_pool[stage.slot]);
+
+      // The bound is taken at launch, it may have improved since the
+      // sequences were submitted
+      stage.batch.schedule_async(
+           incumbent.makespan(),
+           [this, &stage, &incumbent](const BatchScheduleResult& result) {
+              if (result.index < stage.batch.size()) {
+                 Sequence& best = stage.sequences[result.index];
+                 stage.batch.apply_best(best);
+                 incumbent.update(best, result.makespan);
+              }
+
+              std::lock_guard<std::mutex> lock(m_pipeline_mutex);
+              m_timer_expired |= !result.finished;
+              stage.batch.clear();
+              stage.sequences.clear();
+              stage.in_flight = false;
+              m_device_busy[stage.slot] = false;
+           });
+   }
+
+auto pool_devices(const std::size_t devices) -> std::vector<int> {
+      const int visible = omp_get_num_devices();
+      if (visible == 0) {
+         return {omp_get_default_device()};
+      }
+
+      int count = visible;
+      if (devices > 0) {
+         count = std::min(count, static_cast<int>(devices));
+      }
+
+      std::vector<int> pool(count);
+      std::iota(pool.begin(), pool.end(), 0);
+      return pool;
+   }
+
+DevicePool::~DevicePool() {
+      for (BranchAndBoundBatchGPU& batch : m_batches) {
+         batch.release_resident();
+      }
+   }
+
+auto DevicePool::init(const std::size_t devices) -> void {
+      const std::vector<int> pool = pool_devices(devices);
+      if (std::ranges::equal(
+               pool, m_batches, {}, {}, &BranchAndBoundBatchGPU::device)) {
+         clear();
+         return;
+      }
+
+      for (BranchAndBoundBatchGPU& batch : m_batches) {
+         batch.release_resident();
+      }
+      m_batches.clear();
+      m_batches.resize(pool.size());
+      for (std::size_t slot = 0; slot < pool.size(); ++slot) {
+         m_batches[slot].set_device(pool[slot]);
+         m_batches[slot].make_resident(RESIDENT_SEQUENCES);
+      }
+   }
+
+auto DevicePool::set_split_depth(const std::size_t split_depth) -> void {
+      for (BranchAndBoundBatchGPU& batch : m_batches) {
+         batch.set_split_depth(split_depth);
+      }
+   }
+
+auto DevicePool::schedule(const std::size_t upper_bound) -> Result {
+      const std::size_t slots = size();
+      std::vector<BatchScheduleResult> results(
+           slots, {.makespan = upper_bound, .index = 0, .finished = true});
+
+      // The kernels block the host thread that launched them
+      #pragma omp parallel for num_threads(slots) schedule(static, 1)          \
+                               if (slots > 1)
+      for (std::size_t slot = 0; slot < slots; ++slot) {
+         if (m_batches[slot].size() > 0) {
+            results[slot] = m_batches[slot].schedule(upper_bound);
+         }
+      }
+
+      // Cross-device reduction
+      Result best {.makespan = upper_bound, .slot = slots, .index = 0};
+      bool finished = true;
+      for (std::size_t slot = 0; slot < slots; ++slot) {
+         if (results[slot].makespan < best.makespan) {
+            best = {.makespan = results[slot].makespan,
+                    .slot = slot,
+                    .index = results[slot].index};
+         }
+         finished &= results[slot].finished;
+      }
+      best.finished = finished;
+      return best;
+   }
+
+auto DevicePool::clear() -> void {
+      for (BranchAndBoundBatchGPU& batch : m_batches) {
+         batch.clear();
+      }
+   }
+
+auto BranchAndBoundBatchGPU::fits(
+        const Sequence& sequence, const std::size_t usable_threads) -> bool {
+      return sequence.length() <= MAX_SEQUENCE_LENGTH &&
+             usable_threads <= MAX_DEVICE_THREADS;
+   }
+
+auto BranchAndBoundBatchGPU::push_back(
+        const Sequence& sequence, const std::size_t usable_threads) -> void {
+      assert(fits(sequence, usable_threads));
+
+      if (m_offsets.empty()) {
+         m_offsets.push_back(0);
+      }
+      for (const Operation& op : sequence) {
+         PackedOperation& device_op = m_ops.emplace_back(op);
+         // Reset potential previous schedule
+         device_op.is_scheduled = false;
+         device_op.start_time = 0;
+      }
+      m_offsets.push_back(m_ops.size());
+
+      m_usable_threads.push_back(usable_threads);
+      m_sequential_makespans.push_back(sequence.sequential_makespan());
+      m_max_length = std::max(m_max_length, sequence.length());
+      m_max_threads = std::max(m_max_threads, usable_threads);
+   }
+
+auto BranchAndBoundBatchGPU::make_resident(const std::size_t sequences)
+        -> void {
+      release_resident();
+
+      // The device buffers belong to the host buffers, which must not be
+      // reallocated while they are mapped
+      const std::size_t total = sequences * MAX_SEQUENCE_LENGTH;
+      m_ops.reserve(total);
+      m_offsets.reserve(sequences + 1);
+      m_usable_threads.reserve(sequences);
+      m_sequential_makespans.reserve(sequences);
+      m_makespans.reserve(sequences);
+      m_finished.reserve(sequences);
+      m_resident = {.ops = m_ops.data(),
+                    .offsets = m_offsets.data(),
+                    .usable_threads = m_usable_threads.data(),
+                    .sequential_makespans = m_sequential_makespans.data(),
+                    .makespans = m_makespans.data(),
+                    .finished = m_finished.data(),
+                    .sequences = sequences,
+                    .device = m_device};
+
+      // Cannot map std::vector
+      PackedOperation* ops = m_resident.ops;
+      std::size_t* offsets = m_resident.offsets;
+      std::size_t* ut = m_resident.usable_threads;
+      std::size_t* sms = m_resident.sequential_makespans;
+      std::size_t* ms = m_resident.makespans;
+      std::uint8_t* fin = m_resident.finished;
+      const std::size_t n = sequences;
+      const int device = m_device;
+
+      #pragma omp target enter data device(device)                             \
+                                    map(alloc: ops[:total], offsets[:n + 1])   \
+                                    map(alloc: ut[:n], sms[:n])                \
+                                    map(alloc: ms[:n], fin[:n])
+   }
+
+auto BranchAndBoundBatchGPU::release_resident() -> void {
+      if (m_resident.sequences == 0) {
+         return;
+      }
+
+      PackedOperation* ops = m_resident.ops;
+      std::size_t* offsets = m_resident.offsets;
+      std::size_t* ut = m_resident.usable_threads;
+      std::size_t* sms = m_resident.sequential_makespans;
+      std::size_t* ms = m_resident.makespans;
+      std::uint8_t* fin = m_resident.finished;
+      const std::size_t n = m_resident.sequences;
+      const std::size_t total = n * MAX_SEQUENCE_LENGTH;
+      const int device = m_resident.device;
+
+      #pragma omp target exit data device(device)                              \
+                                   map(delete: ops[:total], offsets[:n + 1])   \
+                                   map(delete: ut[:n], sms[:n])                \
+                                   map(delete: ms[:n], fin[:n])
+      m_resident = {};
+   }
+
+auto BranchAndBoundBatchGPU::update_resident() -> void {
+      // The host buffers were reallocated by push_back() meanwhile
+      if (m_resident.sequences > 0 && size() > m_resident.sequences) {
+         make_resident(std::max(2 * m_resident.sequences, size()));
+      }
+   }
+
+auto BranchAndBoundBatchGPU::schedule(const std::size_t upper_bound)
+        -> BatchScheduleResult {
+      update_resident();
+      return dispatch_capacity(
+           m_max_length, m_max_threads,
+           [&]<std::size_t MaxLength, std::size_t MaxThreads>() {
+              if (m_split_depth > 0) {
+                 return launch_queue<MaxLength, MaxThreads>(upper_bound);
+              }
+              return launch<MaxLength, MaxThreads>(upper_bound);
+           });
+   }
+
+template<std::size_t MaxLength, std::size_t MaxThreads>
+auto BranchAndBoundBatchGPU::launch(const std::size_t upper_bound)
+        -> BatchScheduleResult {
+      const std::size_t n = size();
+      const std::size_t total = m_ops.size();
+      m_makespans.assign(n, upper_bound);
+      m_finished.assign(n, true);
+
+      // Cannot map std::vector
+      PackedOperation* ops = m_ops.data();
+      const std::size_t* offsets = m_offsets.data();
+      const std::size_t* ut = m_usable_threads.data();
+      const std::size_t* sms = m_sequential_makespans.data();
+      std::size_t* ms = m_makespans.data();
+      std::uint8_t* fin = m_finished.data();
+      const std::size_t nodes = m_node_budget;
+      const int device = m_device;
+
+      std::size_t best_makespan = upper_bound;
+      std::size_t best_index = n;
+
+      const util::ScopedPhase phase("gpu_batch");
+      count_offload(
+           total * sizeof(PackedOperation) + (4 * n + 1) * sizeof(std::size_t) +
+           n * sizeof(std::uint8_t));
+
+      // Resident buffers are present already, mapping them transfers nothing
+      const bool resident = m_resident.sequences > 0;
+      #pragma omp target update if(resident) device(device)                    \
+                                to(ops[:total], offsets[:n + 1])               \
+                                to(ut[:n], sms[:n], ms[:n], fin[:n])
+
+      // The batch stays resident on the device for both kernels, only the
+      // makespans and the winning schedule are transferred back. The
+      // sequences are stored back to back and padded to MaxLength privately.
+      #pragma omp target data device(device)                                   \
+                              map(to: ops[:total], offsets[:n + 1])            \
+                              map(to: ut[:n], sms[:n])                         \
+                              map(tofrom: ms[:n], fin[:n])
+      {
+         #pragma omp target teams distribute parallel for device(device)       \
+                 map(tofrom: best_makespan) reduction(min: best_makespan)
+         for (std::size_t i = 0; i < n; ++i) {
+            schedule_batch_entry<MaxLength, MaxThreads>(
+                 ops, offsets, ut, sms, ms, fin, i, upper_bound, nodes);
+            best_makespan = std::min(best_makespan, ms[i]);
+         }
+
+         // Lowest index among the sequences with the best makespan, so that
+         // the result doesn't depend on the order in which teams finish.
+         if (best_makespan < upper_bound) {
+            #pragma omp target teams distribute parallel for device(device)    \
+                    map(tofrom: best_index) reduction(min: best_index)
+            for (std::size_t i = 0; i < n; ++i) {
+               if (ms[i] == best_makespan) {
+                  best_index = std::min(best_index, i);
+               }
+            }
+
+            const std::size_t first = m_offsets[best_index];
+            const std::size_t length = m_offsets[best_index + 1] - first;
+            #pragma omp target update device(device) from(ops[first:length])
+         }
+      }
+      #pragma omp target update if(resident) device(device)                    \
+                                from(ms[:n], fin[:n])
+
+      m_best_index = best_index;
+      return {.makespan = best_makespan,
+              .index = best_index,
+              .finished = all_finished()};
+   }
+
+auto BranchAndBoundBatchGPU::schedule_async(
+        const std::size_t upper_bound,
+        std::function<void(const BatchScheduleResult&)> on_done) -> void {
+      assert(size() > 0);
+
+      // The work queue needs the host between its kernels, so the whole
+      // launch becomes one deferred task
+      if (m_split_depth > 0) {
+         #pragma omp task default(shared) firstprivate(upper_bound, on_done)
+         on_done(schedule(upper_bound));
+         return;
+      }
+
+      dispatch_capacity(
+           m_max_length, m_max_threads,
+           [&]<std::size_t MaxLength, std::size_t MaxThreads>() {
+              launch_async<MaxLength, MaxThreads>(
+                   upper_bound, std::move(on_done));
+           });
+   }
+
+template<std::size_t MaxLength, std::size_t MaxThreads>
+auto BranchAndBoundBatchGPU::launch_async(
+        const std::size_t upper_bound,
+        std::function<void(const BatchScheduleResult&)> on_done) -> void {
+      assert(m_resident.sequences == 0);
+
+      const std::size_t n = size();
+      const std::size_t total = m_ops.size();
+      m_makespans.assign(n, upper_bound);
+      m_finished.assign(n, true);
+
+      // Cannot map std::vector
+      PackedOperation* ops = m_ops.data();
+      const std::size_t* offsets = m_offsets.data();
+      const std::size_t* ut = m_usable_threads.data();
+      const std::size_t* sms = m_sequential_makespans.data();
+      std::size_t* ms = m_makespans.data();
+      std::uint8_t* fin = m_finished.data();
+      const std::size_t nodes = m_node_budget;
+      const int device = m_device;
+
+      // Same as launch(), split into tasks that depend on the makespans of
+      // the batch: upload, kernel and the host task that fetches the result.
+      count_offload(
+           total * sizeof(PackedOperation) + (4 * n + 1) * sizeof(std::size_t) +
+           n * sizeof(std::uint8_t));
+
+      #pragma omp target enter data device(device) nowait depend(out: ms[0])   \
+                                    map(to: ops[:total], offsets[:n + 1])      \
+                                    map(to: ut[:n], sms[:n], ms[:n], fin[:n])
+
+      #pragma omp target teams distribute parallel for device(device) nowait   \
+              depend(inout: ms[0]) firstprivate(nodes)
+      for (std::size_t i = 0; i < n; ++i) {
+         schedule_batch_entry<MaxLength, MaxThreads>(
+              ops, offsets, ut, sms, ms, fin, i, upper_bound, nodes);
+      }
+
+      #pragma omp task default(shared) depend(inout: ms[0])                    \
+                       firstprivate(ops, offsets, ut, sms, ms, fin, n, total)  \
+                       firstprivate(device, upper_bound, on_done)
+      {
+         #pragma omp target update device(device) from(ms[:n], fin[:n])
+
+         // Lowest index among the sequences with the best makespan
+         std::size_t best_makespan = upper_bound;
+         std::size_t best_index = n;
+         for (std::size_t i = 0; i < n; ++i) {
+            if (ms[i] < best_makespan) {
+               best_makespan = ms[i];
+               best_index = i;
+            }
+         }
+
+         if (best_index < n) {
+            const std::size_t first = offsets[best_index];
+            const std::size_t length = offsets[best_index + 1] - first;
+            #pragma omp target update device(device) from(ops[first:length])
+         }
+
+         #pragma omp target exit data device(device)                           \
+                                      map(delete: ops[:total])                 \
+                                      map(delete: offsets[:n + 1])             \
+                                      map(delete: ut[:n], sms[:n], ms[:n])     \
+                                      map(delete: fin[:n])
+
+         m_best_index = best_index;
+         on_done({.makespan = best_makespan,
+                  .index = best_index,
+                  .finished = all_finished()});
+      }
+   }
+
+template<std::size_t MaxLength, std::size_t MaxThreads>
+auto BranchAndBoundBatchGPU::launch_queue(const std::size_t upper_bound)
+        -> BatchScheduleResult {
+      const std::size_t n = size();
+      const std::size_t total = m_ops.size();
+      m_makespans.assign(n, upper_bound);
+      m_finished.assign(n, true);
+
+      // Split the search trees into work items on the host. This visits the
+      // same branches as the device, so the items are the surviving nodes at
+      // the split depth (or the root for very short sequences).
+      m_items.clear();
+      m_lower_bounds.clear();
+      for (std::size_t i = 0; i < n; ++i) {
+         const std::size_t length = m_offsets[i + 1] - m_offsets[i];
+         DeviceSearch<MaxLength, MaxThreads> search;
+         search.init(
+              &m_ops[m_offsets[i]], length, m_usable_threads[i],
+              m_sequential_makespans[i]);
+         m_lower_bounds.push_back(device_critical_path(search.working_copy));
+
+         // The split depth bounds this search, it needs no node budget
+         const std::size_t split_depth = std::min(
+              {m_split_depth, MAX_SPLIT_DEPTH, length - 1});
+         std::size_t split_nodes = std::numeric_limits<std::size_t>::max();
+         depth_first_search(
+              search, split_depth, split_nodes,
+              [&]() {
+                 return upper_bound;
+              },
+              [&](const DeviceSearch<MaxLength, MaxThreads>& node) {
+                 WorkItem& item = m_items.emplace_back();
+                 item.sequence = static_cast<std::uint32_t>(i);
+                 item.depth = static_cast<std::uint32_t>(node.depth);
+                 for (std::size_t d = 0; d < node.depth; ++d) {
+                    item.op_idx[d] = node.stack_array[d].op_idx;
+                    item.thread_idx[d] = node.stack_array[d].thread_idx;
+                 }
+                 return false;
+              });
+      }
+
+      const std::size_t num_items = m_items.size();
+      m_item_makespans.assign(num_items, upper_bound);
+      m_item_schedules.resize(num_items * MaxLength);
+
+      // Cannot map std::vector
+      const PackedOperation* ops = m_ops.data();
+      const std::size_t* offsets = m_offsets.data();
+      const std::size_t* ut = m_usable_threads.data();
+      const std::size_t* sms = m_sequential_makespans.data();
+      const std::size_t* lbs = m_lower_bounds.data();
+      const WorkItem* items = m_items.data();
+      std::size_t* ms = m_makespans.data();
+      std::uint8_t* fin = m_finished.data();
+      std::size_t* item_ms = m_item_makespans.data();
+      PackedOperation* schedules = m_item_schedules.data();
+      const std::size_t node_budget = m_node_budget;
+      const int device = m_device;
+
+      std::size_t next_item = 0;
+      std::size_t best_makespan = upper_bound;
+      std::size_t best_index = n;
+      std::size_t best_item = num_items;
+
+      const util::ScopedPhase phase("gpu_batch");
+      count_offload(
+           (total + num_items * MaxLength) * sizeof(PackedOperation) +
+           (5 * n + 1 + num_items) * sizeof(std::size_t) +
+           num_items * sizeof(WorkItem) + n * sizeof(std::uint8_t));
+
+      // Only the work queue is mapped per launch, see launch()
+      const bool resident = m_resident.sequences > 0;
+      #pragma omp target update if(resident) device(device)                    \
+                                to(ops[:total], offsets[:n + 1])               \
+                                to(ut[:n], sms[:n], ms[:n], fin[:n])
+
+      #pragma omp target data device(device)                                   \
+                              map(to: ops[:total], offsets[:n + 1])            \
+                              map(to: ut[:n], sms[:n], lbs[:n])                \
+                              map(to: items[:num_items])                       \
+                              map(tofrom: ms[:n], item_ms[:num_items])         \
+                              map(tofrom: fin[:n])                             \
+                              map(alloc: schedules[:num_items * MaxLength])
+      {
+         // Persistent kernel: every device thread pops work items from the
+         // queue until it is empty. ms[s] is the best makespan of sequence s
+         // found by any thread so far, it is used for pruning by all of them.
+         // The node budget is per device thread, across all of its items.
+         #pragma omp target teams device(device) map(tofrom: next_item)        \
+                 firstprivate(node_budget)
+         #pragma omp parallel
+         {
+            DeviceSearch<MaxLength, MaxThreads> search;
+            std::size_t nodes = node_budget;
+            while (true) {
+               std::size_t item;
+               #pragma omp atomic capture
+               item = next_item++;
+               if (item >= num_items) {
+                  break;
+               }
+
+               const WorkItem& work = items[item];
+               const std::size_t s = work.sequence;
+               const auto best_so_far = [&]() {
+                  std::size_t best;
+                  #pragma omp atomic read
+                  best = ms[s];
+                  return best;
+               };
+
+               // Optimality of the sequence is already proven
+               if (best_so_far() <= lbs[s]) {
+                  continue;
+               }
+
+               // Replay the path to the root of the subtree
+               search.init(
+                    &ops[offsets[s]], offsets[s + 1] - offsets[s], ut[s],
+                    sms[s]);
+               for (std::size_t d = 0; d < work.depth; ++d) {
+                  search.push(work.op_idx[d], work.thread_idx[d]);
+               }
+               if (search.bound() >= best_so_far()) {
+                  continue;
+               }
+
+               const bool finished = depth_first_search(
+                    search, search.working_copy.length, nodes, best_so_far,
+                    [&](const DeviceSearch<MaxLength, MaxThreads>& leaf) {
+                       const std::size_t makespan = leaf.makespan;
+
+                       std::size_t old_makespan;
+                       #pragma omp atomic compare capture
+                       {
+                          old_makespan = ms[s];
+                          if (ms[s] > makespan) {
+                             ms[s] = makespan;
+                          }
+                       }
+
+                       // Only this thread works on the item
+                       if (makespan < old_makespan) {
+                          item_ms[item] = makespan;
+                          PackedOperation* schedule =
+                               &schedules[item * MaxLength];
+                          for (std::size_t k = 0; k < leaf.working_copy.length;
+                               ++k) {
+                             schedule[k] = leaf.working_copy.ops[k];
+                          }
+                       }
+                       return makespan <= lbs[s];
+                    });
+               if (!finished) {
+                  #pragma omp atomic write
+                  fin[s] = 0;
+               }
+            }
+         }
+
+         #pragma omp target teams distribute parallel for device(device)       \
+                 map(tofrom: best_makespan) reduction(min: best_makespan)
+         for (std::size_t i = 0; i < n; ++i) {
+            best_makespan = std::min(best_makespan, ms[i]);
+         }
+
+         // Lowest sequence and item index with the best makespan
+         if (best_makespan < upper_bound) {
+            #pragma omp target teams distribute parallel for device(device)    \
+                    map(tofrom: best_index) reduction(min: best_index)
+            for (std::size_t i = 0; i < n; ++i) {
+               if (ms[i] == best_makespan) {
+                  best_index = std::min(best_index, i);
+               }
+            }
+
+            #pragma omp target teams distribute parallel for device(device)    \
+                    map(tofrom: best_item) reduction(min: best_item)
+            for (std::size_t k = 0; k < num_items; ++k) {
+               if (items[k].sequence == best_index &&
+                   item_ms[k] == best_makespan) {
+                  best_item = std::min(best_item, k);
+               }
+            }
+
+            const std::size_t first = best_item * MaxLength;
+            const std::size_t length = offsets[best_index + 1] -
+                                       offsets[best_index];
+            #pragma omp target update device(device)                           \
+                    from(schedules[first:length])
+         }
+      }
+      #pragma omp target update if(resident) device(device)                    \
+                                from(ms[:n], fin[:n])
+
+      // Store the winning schedule where apply_best() expects it
+      m_best_index = best_index;
+      if (best_index < n) {
+         std::copy_n(
+              &m_item_schedules[best_item * MaxLength],
+              m_offsets[best_index + 1] - m_offsets[best_index],
+              &m_ops[m_offsets[best_index]]);
+      }
+      return {.makespan = best_makespan,
+              .index = best_index,
+              .finished = all_finished()};
+   }
 
+auto BranchAndBoundBatchGPU::apply_best(Sequence& sequence) const -> void {
+      assert(m_best_index < size());
+      const std::size_t first = m_offsets[m_best_index];
+      assert(sequence.length() == m_offsets[m_best_index + 1] - first);
 
-      //Return gpu output with catch if gpu offload failed
-      if(!notrangpu){
-        return 0;
-      } else{
-        best_makespan = result_sequence.best_makespan_output;
-        return best_makespan;
+      const PackedOperation* best = &m_ops[first];
+      for (std::size_t i = 0; i < sequence.length(); ++i) {
+         sequence[i].thread = best[i].thread;
+         sequence[i].start_time = best[i].start_time;
+         sequence[i].is_scheduled = true;
       }
    }
 
-}  // namespace jcdp::scheduler
\ No newline at end of file
+}  // namespace jcdp::scheduler
@@ -14,6 +14,7 @@
 #include <iostream>
 #include <memory>
 
+#include "jcdp/chain_corpus.hpp"
 #include "jcdp/generator.hpp"
 #include "jcdp/jacobian_chain.hpp"
 #include "jcdp/operation.hpp"
@@ -26,6 +27,7 @@
 #include "jcdp/scheduler/bnb_block.hpp"
 #include "jcdp/sequence.hpp"
 #include "jcdp/util/dot_writer.hpp"
+#include "jcdp/util/instrumentation.hpp"
 
 #include "omp.h"
 
@@ -55,6 +57,7 @@ int main(int argc, char* argv[]) {
    if (argc < 2) {
       jcgen.print_help(std::cout);
       dp_solver.print_help(std::cout);
+      jcdp::util::instrumentation().print_help(std::cout);
       return -1;
    }
 
@@ -63,8 +66,12 @@ int main(int argc, char* argv[]) {
       dp_solver.parse_config(config_filename, true);
       bnb_solver.parse_config(config_filename, true);
       bnb_block_solver.parse_config(config_filename, true);
+      bnb_scheduler.parse_config(config_filename, true);
+      bnb_scheduler_gpu.parse_config(config_filename, true);
       jcgen.parse_config(config_filename, true);
-      jcgen.init_rng();
+      jcgen.set_chain_source(jcdp::open_chain_corpus(jcgen.corpus_path()));
+      jcgen.init();
+      jcdp::util::instrumentation().parse_config(config_filename, true);
    } catch (const std::runtime_error& bcfe) {
       std::println(std::cerr, "{}", bcfe.what());
       return -1;
@@ -126,6 +133,8 @@ int main(int argc, char* argv[]) {
    // Solve via branch & bound + List scheduling
    bnb_solver.init(chain, list_s_p);
    bnb_solver.set_upper_bound(dp_seq.makespan());
+   bnb_solver.set_sequential_cost(dp_solver.sequential_cost());
+   bnb_solver.set_guide(dp_seq);
    auto start_bnb_list = std::chrono::high_resolution_clock::now();
    jcdp::Sequence bnb_seq_list = bnb_solver.solve();
    auto end_bnb_list = std::chrono::high_resolution_clock::now();
@@ -142,6 +151,8 @@ int main(int argc, char* argv[]) {
    // Solve via branch & bound
    bnb_solver.init(chain, bnb_s_p);
    bnb_solver.set_upper_bound(dp_seq.makespan());
+   bnb_solver.set_sequential_cost(dp_solver.sequential_cost());
+   bnb_solver.set_guide(dp_seq);
    auto start_bnb = std::chrono::high_resolution_clock::now();
    jcdp::Sequence bnb_seq = bnb_solver.solve();
    auto end_bnb = std::chrono::high_resolution_clock::now();
@@ -156,6 +167,8 @@ int main(int argc, char* argv[]) {
    }
    // Solve via branch & bound (GPU branch & bound scheduler)
    bnb_solver.init(chain, bnb_s_g_p);
+   bnb_solver.set_sequential_cost(dp_solver.sequential_cost());
+   bnb_solver.set_guide(dp_seq);
    auto start_bnb_gpu = std::chrono::high_resolution_clock::now();
    jcdp::Sequence bnb_seq_gpu = bnb_solver.solve();
    auto end_bnb_gpu = std::chrono::high_resolution_clock::now();
@@ -202,6 +215,13 @@ int main(int argc, char* argv[]) {
      jcdp::util::write_dot(bnb_seq_block, "branch_and_bound");
    }
 
+   try {
+      jcdp::util::instrumentation().finish(std::cout);
+   } catch (const std::runtime_error& e) {
+      std::println(std::cerr, "{}", e.what());
+      return -1;
+   }
+
 
 
    
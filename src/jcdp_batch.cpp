@@ -4,17 +4,29 @@
  * @brief This file is part of the JCDP package. It provides an application that
  *        generated multiple Jacobian chains and runs all available solvers on
  *        them. The makespan of the calculated sequences are stored in CSV
- *        files. The generator and solver properties can be provided via a
- *        config files that is expected as the first command line argument.
+ *        and/or binary record files. The generator and solver properties
+ *        can be provided via a config files that is expected as the first
+ *        command line argument.
  ******************************************************************************/
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
+#include <chrono>
+#include <cstddef>
 #include <filesystem>
+#include <format>
+#include <fstream>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <numeric>
+#include <ostream>
+#include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "jcdp/chain_corpus.hpp"
 #include "jcdp/generator.hpp"
 #include "jcdp/jacobian_chain.hpp"
 #include "jcdp/optimizer/branch_and_bound.hpp"
@@ -22,35 +34,421 @@
 #include "jcdp/scheduler/branch_and_bound.hpp"
 #include "jcdp/scheduler/branch_and_bound_gpu.hpp"
 #include "jcdp/scheduler/priority_list.hpp"
+#include "jcdp/util/instrumentation.hpp"
+#include "jcdp/util/properties.hpp"
+#include "jcdp/util/record_writer.hpp"
+#include "jcdp/util/reorder_buffer.hpp"
+#include "jcdp/workspace.hpp"
 
-// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> APPLICATION <<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+#include "omp.h"
 
-int main(int argc, char* argv[]) {
-   jcdp::JacobianChainGenerator jcgen;
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> BATCH ENGINE <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace {
+
+//! How the (chain, threads) jobs of the batch are spread over the threads.
+class BatchProperties : public jcdp::util::Properties {
+ public:
+   BatchProperties() {
+      register_property(
+           m_jobs, "batch_jobs",
+           "Amount of (chain, threads) jobs that are solved concurrently, "
+           "each with its own solvers (0 = one per OpenMP thread).");
+      register_property(
+           m_nested_threads, "batch_nested_threads",
+           "Threads of the parallel regions inside of the solvers while "
+           "batch_jobs > 1 (1 = solvers run serially).");
+      register_property(
+           m_sweep, "batch_sweep",
+           "Wether the branch & bound solvers optimize all thread counts of "
+           "a chain in a single pass (one job per chain).");
+      register_property(
+           m_output, "batch_output",
+           "Format of the results: csv, binary (fixed-width records with "
+           "timings and counters) or both.");
+      register_property(
+           m_save_corpus, "batch_save_corpus",
+           "Chain corpus file to save all chains of the batch to, e.g. to "
+           "solve the same chains again via chain_corpus.");
+   }
+
+   //! Throws if a property has an invalid value.
+   inline auto validate() const -> void {
+      if (m_output != "csv" && m_output != "binary" && m_output != "both") {
+         throw std::runtime_error(
+              "Unknown batch output \"" + m_output + "\"");
+      }
+   }
+
+   inline auto jobs() const -> std::size_t {
+      return m_jobs > 0 ? m_jobs : omp_get_max_threads();
+   }
+
+   inline auto nested_threads() const -> std::size_t {
+      return std::max<std::size_t>(m_nested_threads, 1);
+   }
+
+   inline auto sweep() const -> bool {
+      return m_sweep;
+   }
+
+   inline auto csv() const -> bool {
+      return m_output != "binary";
+   }
+
+   inline auto binary() const -> bool {
+      return m_output != "csv";
+   }
+
+   inline auto save_corpus() const -> const std::string& {
+      return m_save_corpus;
+   }
+
+ private:
+   std::size_t m_jobs {1};
+   std::size_t m_nested_threads {1};
+   bool m_sweep {false};
+   std::string m_output {"csv"};
+   std::string m_save_corpus {};
+};
+
+//! Solvers of one batch thread.
+struct Solvers {
    jcdp::optimizer::DynamicProgrammingOptimizer dp_solver;
    jcdp::optimizer::BranchAndBoundOptimizer bnb_solver;
+   jcdp::scheduler::PriorityListScheduler list_scheduler;
+   jcdp::scheduler::BranchAndBoundScheduler bnb_scheduler;
+   jcdp::scheduler::BranchAndBoundSchedulerGPU bnb_scheduler_gpu;
+
+   //! Chain the dynamic programming solution belongs to
+   std::size_t dp_chain {std::numeric_limits<std::size_t>::max()};
+   double dp_time {0};
+
+   //! The workspace is shared, every thread uses its own buffers of it.
+   Solvers(
+        const std::filesystem::path& config, jcdp::Workspace& workspace,
+        const std::size_t max_length) {
+      dp_solver.parse_config(config, true);
+      bnb_solver.parse_config(config, true);
+      bnb_scheduler.parse_config(config, true);
+      bnb_scheduler_gpu.parse_config(config, true);
+
+      list_scheduler.set_workspace(&workspace);
+      bnb_scheduler.set_workspace(&workspace);
+      dp_solver.reserve(max_length);
+      bnb_solver.reserve(max_length);
+   }
+};
+
+//! All chains of one length, written to one CSV and/or binary file.
+struct LengthBatch {
+   std::size_t length {0};
+   //! Index of the first chain among all chains of the batch
+   std::size_t first_chain {0};
+   std::vector<jcdp::JacobianChain> chains {};
+   std::ofstream out {};
+   std::unique_ptr<jcdp::util::ReorderBuffer> rows {};
+   //! One part per thread count, after the one of the chain
+   std::ofstream binary_out {};
+   std::unique_ptr<jcdp::util::ReorderBuffer> records {};
+};
+
+//! Result of one solver for one thread count.
+struct SolverResult {
+   std::size_t makespan {0};
+   bool finished {true};
+   //! Wall time in seconds
+   double time {0};
+   std::size_t leafs {0};
+   std::size_t pruned_branches {0};
+};
+
+//! Results of all solvers for one thread count.
+struct ThreadsResult {
+   SolverResult bnb {};
+   SolverResult bnb_gpu {};
+   SolverResult bnb_list {};
+   SolverResult dp {};
+   SolverResult dp_bnb {};
+};
+
+using Clock = std::chrono::steady_clock;
+
+inline auto seconds_since(const Clock::time_point start) -> double {
+   return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+//! Result of the last search of the branch & bound solver.
+auto bnb_result(
+     const jcdp::optimizer::BranchAndBoundOptimizer& bnb_solver,
+     const std::size_t makespan, const double time) -> SolverResult {
+   const jcdp::optimizer::BranchAndBoundOptimizer::Statistics stats =
+        bnb_solver.statistics();
+   return {
+        .makespan = makespan,
+        .finished = bnb_solver.finished_in_time(),
+        .time = time,
+        .leafs = stats.leafs,
+        .pruned_branches = std::accumulate(
+             stats.pruned_branches.cbegin(), stats.pruned_branches.cend(),
+             std::size_t {0})};
+}
+
+//! Solve the chain for t threads with all solvers.
+auto solve(
+     Solvers& solvers, const jcdp::JacobianChain& chain,
+     const std::size_t chain_idx, const std::size_t len, const std::size_t t)
+     -> ThreadsResult {
+   auto& [dp_solver, bnb_solver, list_scheduler, bnb_scheduler,
+          bnb_scheduler_gpu, dp_chain, dp_time] = solvers;
+   ThreadsResult result;
+
+   // Solve via dynamic programming (once for all thread counts)
+   if (dp_chain != chain_idx) {
+      const Clock::time_point start = Clock::now();
+      dp_solver.init(chain);
+      dp_solver.m_usable_threads = len;
+      dp_solver.solve();
+      dp_chain = chain_idx;
+      dp_time = seconds_since(start);
+
+      // Schedules are shared between the thread counts of one chain only
+      bnb_solver.clear_schedule_cache();
+   }
+
+   jcdp::Sequence dp_seq = dp_solver.get_sequence(t);
+   result.dp = {.makespan = dp_seq.makespan(), .time = dp_time};
+
+   // Schedule dynamic programming sequence via branch & bound
+   Clock::time_point start = Clock::now();
+   bnb_scheduler.schedule(dp_seq, t, result.dp.makespan);
+   result.dp_bnb = {
+        .makespan = dp_seq.makespan(),
+        .finished = bnb_scheduler.finished_in_time(),
+        .time = seconds_since(start)};
+
+   // Solve via branch & bound + List scheduling
+   start = Clock::now();
+   bnb_solver.init(chain, &list_scheduler);
+   bnb_solver.set_upper_bound(dp_seq.makespan());
+   bnb_solver.set_sequential_cost(dp_solver.sequential_cost());
+   bnb_solver.set_guide(dp_seq);
+   bnb_solver.m_usable_threads = t;
+   jcdp::Sequence bnb_seq_list = bnb_solver.solve();
+   result.bnb_list = bnb_result(
+        bnb_solver, bnb_seq_list.makespan(), seconds_since(start));
+
+   // Solve via branch & bound + branch & bound scheduling
+   start = Clock::now();
+   bnb_solver.init(chain, &bnb_scheduler);
+   bnb_solver.set_upper_bound(bnb_seq_list.makespan());
+   bnb_solver.set_sequential_cost(dp_solver.sequential_cost());
+   bnb_solver.set_guide(bnb_seq_list);
+   bnb_solver.m_usable_threads = t;
+   jcdp::Sequence bnb_seq = bnb_solver.solve();
+   result.bnb = bnb_result(
+        bnb_solver, bnb_seq.makespan(), seconds_since(start));
+
+   // Solve via branch & bound + branch & bound GPU scheduling
+   start = Clock::now();
+   bnb_solver.init(chain, &bnb_scheduler_gpu);
+   bnb_solver.set_upper_bound(bnb_seq_list.makespan());
+   bnb_solver.set_sequential_cost(dp_solver.sequential_cost());
+   bnb_solver.set_guide(bnb_seq_list);
+   bnb_solver.m_usable_threads = t;
+   jcdp::Sequence bnb_seq_gpu = bnb_solver.solve();
+   result.bnb_gpu = bnb_result(
+        bnb_solver, bnb_seq_gpu.makespan(), seconds_since(start));
+
+   return result;
+}
+
+//! Same as solve() for all thread counts at once, with the branch & bound
+//! solvers sweeping over the thread counts (see solve_sweep()). The time
+//! and counters of a sweep are the ones of the whole pass.
+auto solve_sweep(
+     Solvers& solvers, const jcdp::JacobianChain& chain, const std::size_t len)
+     -> std::vector<ThreadsResult> {
+   auto& [dp_solver, bnb_solver, list_scheduler, bnb_scheduler,
+          bnb_scheduler_gpu, dp_chain, dp_time] = solvers;
+   std::vector<ThreadsResult> results(len);
+
+   // Solve via dynamic programming
+   Clock::time_point start = Clock::now();
+   dp_solver.init(chain);
+   dp_solver.m_usable_threads = len;
+   dp_solver.solve();
+   dp_chain = std::numeric_limits<std::size_t>::max();
+   dp_time = seconds_since(start);
+   bnb_solver.clear_schedule_cache();
+
+   // Schedule dynamic programming sequences via branch & bound
+   std::vector<std::size_t> upper_bounds;
+   for (std::size_t t = 1; t <= len; ++t) {
+      ThreadsResult& result = results[t - 1];
+      jcdp::Sequence dp_seq = dp_solver.get_sequence(t);
+      result.dp = {.makespan = dp_seq.makespan(), .time = dp_time};
+
+      start = Clock::now();
+      bnb_scheduler.schedule(dp_seq, t, result.dp.makespan);
+      result.dp_bnb = {
+           .makespan = dp_seq.makespan(),
+           .finished = bnb_scheduler.finished_in_time(),
+           .time = seconds_since(start)};
+      upper_bounds.push_back(dp_seq.makespan());
+   }
+
+   // Solve via branch & bound + List scheduling
+   start = Clock::now();
+   bnb_solver.init(chain, &list_scheduler);
+   bnb_solver.set_sequential_cost(dp_solver.sequential_cost());
+   bnb_solver.set_guide(dp_solver.get_sequence(len));
+   std::vector<jcdp::Sequence> bnb_seqs_list = bnb_solver.solve_sweep(
+        upper_bounds);
+   double time = seconds_since(start);
+   for (std::size_t t = 0; t < len; ++t) {
+      upper_bounds[t] = bnb_seqs_list[t].makespan();
+      results[t].bnb_list = bnb_result(bnb_solver, upper_bounds[t], time);
+   }
+
+   // Solve via branch & bound + branch & bound scheduling
+   start = Clock::now();
+   bnb_solver.init(chain, &bnb_scheduler);
+   bnb_solver.set_sequential_cost(dp_solver.sequential_cost());
+   bnb_solver.set_guide(bnb_seqs_list.back());
+   std::vector<jcdp::Sequence> bnb_seqs = bnb_solver.solve_sweep(
+        upper_bounds);
+   time = seconds_since(start);
+   for (std::size_t t = 0; t < len; ++t) {
+      results[t].bnb = bnb_result(bnb_solver, bnb_seqs[t].makespan(), time);
+   }
+
+   // Solve via branch & bound + branch & bound GPU scheduling. Its batches
+   // share one incumbent, so every thread count gets a pass of its own.
+   for (std::size_t t = 1; t <= len; ++t) {
+      start = Clock::now();
+      bnb_solver.init(chain, &bnb_scheduler_gpu);
+      bnb_solver.set_upper_bound(upper_bounds[t - 1]);
+      bnb_solver.set_sequential_cost(dp_solver.sequential_cost());
+      bnb_solver.set_guide(bnb_seqs_list[t - 1]);
+      bnb_solver.m_usable_threads = t;
+      jcdp::Sequence bnb_seq_gpu = bnb_solver.solve();
+      results[t - 1].bnb_gpu = bnb_result(
+           bnb_solver, bnb_seq_gpu.makespan(), seconds_since(start));
+   }
+   return results;
+}
 
-   jcdp::scheduler::PriorityListScheduler list_scheduler = jcdp::scheduler::PriorityListScheduler();
-   jcdp::scheduler::PriorityListScheduler* list_s_p = &list_scheduler;
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> OUTPUT <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
-   jcdp::scheduler::BranchAndBoundScheduler bnb_scheduler = jcdp::scheduler::BranchAndBoundScheduler();
-   jcdp::scheduler::BranchAndBoundScheduler* bnb_s_p = &bnb_scheduler;
+//! CSV cells of one thread count (in the order of write_csv_header()).
+auto csv_cells(const ThreadsResult& r) -> std::string {
+   return std::format(
+        "{},{},{},{},{},{},{}", r.bnb.finished, r.bnb.makespan,
+        r.bnb_gpu.finished, r.bnb_gpu.makespan, r.bnb_list.makespan,
+        r.dp.makespan, r.dp_bnb.makespan);
+}
+
+auto write_csv_header(std::ostream& out, const std::size_t len) -> void {
+   for (std::size_t t = 1; t <= len; ++t) {
+      std::print(out, "BnB_BnB/{}/finished,", t);
+      std::print(out, "BnB_BnB/{},", t);
+      std::print(out, "BnB_BnB_GPU/{}/finished,", t);
+      std::print(out, "BnB_BnB_GPU/{},", t);
+      std::print(out, "BnB_List/{},", t);
+      std::print(out, "DP/{},", t);
+      std::print(out, "DP_BnB/{}{}", t, (t < len) ? "," : "\n");
+   }
+}
 
-   jcdp::scheduler::BranchAndBoundSchedulerGPU bnb_scheduler_gpu = jcdp::scheduler::BranchAndBoundSchedulerGPU();
-   jcdp::scheduler::BranchAndBoundSchedulerGPU* bnb_s_g_p = &bnb_scheduler_gpu;
+//! Columns of the binary results: the chain parameters, followed by all
+//! solvers per thread count. The makespan column of a solver has the same
+//! name as in the CSV file.
+auto binary_schema(const std::size_t len) -> jcdp::util::RecordSchema {
+   using jcdp::util::ColumnType;
+   jcdp::util::RecordSchema schema;
+
+   schema.add("chain", ColumnType::UINT64);
+   for (std::size_t k = 0; k < len; ++k) {
+      for (const char* param :
+           {"n", "m", "non_zero_elements", "edges_in_dag", "tangent_cost",
+            "adjoint_cost"}) {
+         schema.add(std::format("J{}/{}", k, param), ColumnType::UINT64);
+      }
+   }
+
+   for (std::size_t t = 1; t <= len; ++t) {
+      for (const char* solver :
+           {"BnB_BnB", "BnB_BnB_GPU", "BnB_List", "DP", "DP_BnB"}) {
+         const std::string name = std::format("{}/{}", solver, t);
+         schema.add(name, ColumnType::UINT64);
+         schema.add(name + "/finished", ColumnType::BOOL);
+         schema.add(name + "/time", ColumnType::FLOAT64);
+         schema.add(name + "/leafs", ColumnType::UINT64);
+         schema.add(name + "/pruned_branches", ColumnType::UINT64);
+      }
+   }
+   return schema;
+}
+
+//! Leading fields of a record (see binary_schema()).
+auto chain_fields(const jcdp::JacobianChain& chain, const std::size_t idx)
+     -> std::string {
+   jcdp::util::RecordFields fields;
+   fields.add(idx);
+   for (const jcdp::Jacobian& jac : chain.elemental_jacobians) {
+      fields.add(jac.n)
+           .add(jac.m)
+           .add(jac.non_zero_elements)
+           .add(jac.edges_in_dag)
+           .add(jac.tangent_cost)
+           .add(jac.adjoint_cost);
+   }
+   return std::move(fields).bytes();
+}
+
+//! Fields of one thread count (see binary_schema()).
+auto threads_fields(const ThreadsResult& r) -> std::string {
+   jcdp::util::RecordFields fields;
+   for (const SolverResult* s :
+        {&r.bnb, &r.bnb_gpu, &r.bnb_list, &r.dp, &r.dp_bnb}) {
+      fields.add(s->makespan)
+           .add(s->finished)
+           .add(s->time)
+           .add(s->leafs)
+           .add(s->pruned_branches);
+   }
+   return std::move(fields).bytes();
+}
+
+}  // end namespace
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> APPLICATION <<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+int main(int argc, char* argv[]) {
+   jcdp::JacobianChainGenerator jcgen;
+   BatchProperties batch;
 
    if (argc < 2) {
       jcgen.print_help(std::cout);
-      dp_solver.print_help(std::cout);
+      jcdp::optimizer::DynamicProgrammingOptimizer().print_help(std::cout);
+      batch.print_help(std::cout);
+      jcdp::util::instrumentation().print_help(std::cout);
       return -1;
    }
 
    const std::filesystem::path config_filename(argv[1]);
+   jcdp::Workspace workspace;
+   std::unique_ptr<Solvers> main_solvers;
    try {
-      dp_solver.parse_config(config_filename, true);
-      bnb_solver.parse_config(config_filename, true);
       jcgen.parse_config(config_filename, true);
-      jcgen.init_rng();
+      jcgen.set_chain_source(jcdp::open_chain_corpus(jcgen.corpus_path()));
+      jcgen.init();
+      batch.parse_config(config_filename, true);
+      batch.validate();
+      jcdp::util::instrumentation().parse_config(config_filename, true);
+      main_solvers = std::make_unique<Solvers>(
+           config_filename, workspace, jcgen.max_length());
    } catch (const std::runtime_error& bcfe) {
       std::println(std::cerr, "{}", bcfe.what());
       return -1;
@@ -61,77 +459,163 @@ int main(int argc, char* argv[]) {
       output_file_name = argv[2];
    }
 
+   // Generate all chains upfront, in the same order (and with the same
+   // random numbers) as a sequential run
+   std::vector<LengthBatch> batches;
+   std::size_t chains = 0;
    jcdp::JacobianChain chain;
    while (!jcgen.empty()) {
-      const std::size_t len = jcgen.current_length();
-      std::filesystem::path output_file =
-           (output_file_name + std::to_string(len) + ".csv");
+      LengthBatch& lb = batches.emplace_back();
+      lb.length = jcgen.current_length();
+      lb.first_chain = chains;
+      while (jcgen.next(chain)) {
+         chain.init_subchains();
+         lb.chains.push_back(chain);
+      }
+      chains += lb.chains.size();
+
+      const std::string output_file =
+           output_file_name + std::to_string(lb.length);
+      if (batch.csv()) {
+         lb.out.open(output_file + ".csv");
+         if (!lb.out) {
+            std::println(std::cerr, "Failed to open {}.csv", output_file);
+            return -1;
+         }
+         write_csv_header(lb.out, lb.length);
+      }
+      if (batch.binary()) {
+         lb.binary_out.open(output_file + ".jcdprec", std::ios::binary);
+         if (!lb.binary_out) {
+            std::println(std::cerr, "Failed to open {}.jcdprec", output_file);
+            return -1;
+         }
+         binary_schema(lb.length).write_header(lb.binary_out);
+      }
+   }
 
-      std::ofstream out(output_file);
-      if (!out) {
-         std::println(std::cerr, "Failed to open {}", output_file.string());
+   if (!batch.save_corpus().empty()) {
+      try {
+         jcdp::ChainCorpusWriter corpus(batch.save_corpus());
+         for (const LengthBatch& lb : batches) {
+            for (const jcdp::JacobianChain& c : lb.chains) {
+               corpus.add(c);
+            }
+         }
+         corpus.finish();
+      } catch (const std::runtime_error& e) {
+         std::println(std::cerr, "{}", e.what());
          return -1;
       }
+   }
 
-      for (std::size_t t = 1; t <= len; ++t) {
-         std::print(out, "BnB_BnB/{}/finished,", t);
-         std::print(out, "BnB_BnB/{},", t);
-         std::print(out, "BnB_BnB_GPU/{}/finished,", t);
-         std::print(out, "BnB_BnB_GPU/{},", t);
-         std::print(out, "BnB_List/{},", t);
-         std::print(out, "DP/{},", t);
-         std::print(out, "DP_BnB/{}{}", t, (t < len) ? "," : "\n");
+   // Only now that the batches don't move anymore
+   for (LengthBatch& lb : batches) {
+      if (batch.csv()) {
+         lb.rows = std::make_unique<jcdp::util::ReorderBuffer>(
+              lb.out, lb.chains.size(), lb.length);
+      }
+      if (batch.binary()) {
+         lb.records = std::make_unique<jcdp::util::ReorderBuffer>(
+              lb.binary_out, lb.chains.size(), lb.length + 1, "", "");
       }
+   }
 
-      while (jcgen.next(chain)) {
-         chain.init_subchains();
+   // One job per chain and thread count (all thread counts if sweeping).
+   // Jobs of the same chain are next to each other, so that a thread can
+   // usually reuse its DP solution.
+   struct Job {
+      std::size_t batch {0};
+      std::size_t chain {0};
+      std::size_t threads {0};
+   };
+   std::vector<Job> jobs;
+   for (std::size_t b = 0; b < batches.size(); ++b) {
+      for (std::size_t c = 0; c < batches[b].chains.size(); ++c) {
+         if (batch.sweep()) {
+            jobs.push_back({.batch = b, .chain = c});
+            continue;
+         }
+         for (std::size_t t = 1; t <= batches[b].length; ++t) {
+            jobs.push_back({.batch = b, .chain = c, .threads = t});
+         }
+      }
+   }
 
-         // Solve via dynamic programming
-         dp_solver.init(chain);
-         dp_solver.m_usable_threads = len;
-         dp_solver.solve();
-
-         for (std::size_t t = 1; t <= len; ++t) {
-            jcdp::Sequence dp_seq = dp_solver.get_sequence(t);
-            const std::size_t dp_makespan = dp_seq.makespan();
-
-            // Schedule dynamic programming sequence via branch & bound
-            bnb_s_p->schedule(dp_seq, t, dp_makespan);
-
-            // Solve via branch & bound + List scheduling
-            bnb_solver.init(chain, list_s_p);
-            bnb_solver.set_upper_bound(dp_seq.makespan());
-            bnb_solver.m_usable_threads = t;
-            jcdp::Sequence bnb_seq_list = bnb_solver.solve();
-
-            // Solve via branch & bound + branch & bound scheduling
-            bnb_solver.init(chain, bnb_s_p);
-            bnb_solver.set_upper_bound(bnb_seq_list.makespan());
-            bnb_solver.m_usable_threads = t;
-            jcdp::Sequence bnb_seq = bnb_solver.solve();
-            const bool finished_bnb = bnb_solver.finished_in_time();
-
-            // Solve via branch & bound + branch & bound GPU scheduling
-            bnb_solver.init(chain, bnb_s_g_p);
-            bnb_solver.set_upper_bound(bnb_seq_list.makespan());
-            bnb_solver.m_usable_threads = t;
-            jcdp::Sequence bnb_seq_gpu = bnb_solver.solve();
-            const bool finished_bnb_gpu = bnb_solver.finished_in_time();
-
-            std::print(out, "{},", finished_bnb);
-            std::print(out, "{},", bnb_seq.makespan());
-            std::print(out, "{},", finished_bnb_gpu);
-            std::print(out, "{},", bnb_seq_gpu.makespan());
-            std::print(out, "{},", bnb_seq_list.makespan());
-            std::print(out, "{},", dp_makespan);
-            std::print(out, "{}{}", dp_seq.makespan(),
-                       (t < len) ? "," : "\n");
+   const auto put = [&](LengthBatch& lb, const std::size_t chain,
+                        const std::size_t t, const ThreadsResult& result) {
+      if (lb.rows) {
+         lb.rows->put(chain, t - 1, csv_cells(result));
+      }
+      if (lb.records) {
+         if (t == 1) {
+            lb.records->put(chain, 0, chain_fields(lb.chains[chain], chain));
          }
+         lb.records->put(chain, t, threads_fields(result));
+      }
+   };
 
-         out.flush();
+   const auto run_job = [&](Solvers& solvers, const Job& job) {
+      LengthBatch& lb = batches[job.batch];
+      if (job.threads == 0) {
+         const std::vector<ThreadsResult> results = solve_sweep(
+              solvers, lb.chains[job.chain], lb.length);
+         for (std::size_t t = 1; t <= lb.length; ++t) {
+            put(lb, job.chain, t, results[t - 1]);
+         }
+         return;
+      }
+      put(lb, job.chain, job.threads,
+          solve(solvers, lb.chains[job.chain], lb.first_chain + job.chain,
+                lb.length, job.threads));
+   };
+
+   // Size all buffers for the longest chain once, so that the sweep over many
+   // small chains doesn't reallocate. Either the solvers or the batch jobs
+   // run in parallel, with one set of buffers per thread.
+   const std::size_t concurrent_jobs = std::min(batch.jobs(), jobs.size());
+   workspace.reserve(
+        jcgen.max_length(),
+        std::max<std::size_t>(omp_get_max_threads(), concurrent_jobs));
+   if (concurrent_jobs <= 1) {
+      for (const Job& job : jobs) {
+         run_job(*main_solvers, job);
+      }
+   } else {
+      // Nested solver regions are active only on request, their threads
+      // then allocate their own buffers
+      const std::size_t nested_threads = batch.nested_threads();
+      omp_set_max_active_levels(nested_threads > 1 ? 2 : 1);
+
+      #pragma omp parallel num_threads(concurrent_jobs) default(shared)
+      {
+         omp_set_num_threads(nested_threads);
+
+         // The solvers of the first thread already exist
+         std::unique_ptr<Solvers> own_solvers;
+         if (omp_get_thread_num() > 0) {
+            own_solvers = std::make_unique<Solvers>(
+                 config_filename, workspace, jcgen.max_length());
+         }
+         Solvers& solvers = own_solvers ? *own_solvers : *main_solvers;
+
+         #pragma omp for schedule(dynamic, 1)
+         for (std::size_t j = 0; j < jobs.size(); ++j) {
+            run_job(solvers, jobs[j]);
+         }
       }
+   }
 
-      out.close();
+   for (LengthBatch& lb : batches) {
+      lb.out.close();
+      lb.binary_out.close();
+   }
+
+   try {
+      jcdp::util::instrumentation().finish(std::cout);
+   } catch (const std::runtime_error& e) {
+      std::println(std::cerr, "{}", e.what());
+      return -1;
    }
 
    return 0;
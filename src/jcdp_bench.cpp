@@ -0,0 +1,369 @@
+/******************************************************************************
+ * @file jcdp_bench.cpp
+ *
+ * @brief This file is part of the JCDP package. It provides microbenchmarks
+ *        (Google Benchmark) of the Sequence primitives, the schedulers and
+ *        the optimizers on chains that are generated from a config file,
+ *        which is expected as the first command line argument.
+ ******************************************************************************/
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "jcdp/chain_corpus.hpp"
+#include "jcdp/generator.hpp"
+#include "jcdp/jacobian_chain.hpp"
+#include "jcdp/operation.hpp"
+#include "jcdp/optimizer/branch_and_bound.hpp"
+#include "jcdp/optimizer/dynamic_programming.hpp"
+#include "jcdp/scheduler/branch_and_bound.hpp"
+#include "jcdp/scheduler/branch_and_bound_gpu.hpp"
+#include "jcdp/scheduler/priority_list.hpp"
+#include "jcdp/sequence.hpp"
+#include "jcdp/util/properties.hpp"
+#include "jcdp/workspace.hpp"
+
+#include "omp.h"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> BENCHMARKS <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace {
+
+//! Thread counts and time limits of the benchmarks. The chains are the first
+//! one of every length of the chain generator (use a fixed seed).
+class BenchProperties : public jcdp::util::Properties {
+ public:
+   BenchProperties() {
+      register_property(
+           m_threads, "bench_threads",
+           "Thread counts the schedulers and optimizers are benchmarked "
+           "with (counts above the chain length are skipped).");
+      register_property(
+           m_schedule_time, "bench_schedule_time",
+           "Maximal runtime of a single call of the branch & bound "
+           "schedulers in seconds.");
+   }
+
+   inline auto threads() const -> const std::vector<std::size_t>& {
+      return m_threads;
+   }
+
+   inline auto schedule_time() const -> double {
+      return m_schedule_time;
+   }
+
+ private:
+   std::vector<std::size_t> m_threads {1, 2, 4};
+   double m_schedule_time {1};
+};
+
+//! Chain of one length and its dynamic programming sequences.
+struct BenchChain {
+   jcdp::JacobianChain chain {};
+   //! Per thread count, index 0 is the one for unlimited threads
+   std::vector<jcdp::Sequence> dp_sequences {};
+   //! Work bound of the branch & bound optimizer, see sequential_cost()
+   std::size_t sequential_cost {0};
+};
+
+//! Everything the benchmarks share, set up once before they run.
+struct BenchContext {
+   BenchProperties properties;
+   jcdp::Workspace workspace;
+   std::vector<BenchChain> chains;
+
+   jcdp::optimizer::DynamicProgrammingOptimizer dp_solver;
+   jcdp::optimizer::BranchAndBoundOptimizer bnb_solver;
+   jcdp::scheduler::PriorityListScheduler list_scheduler;
+   jcdp::scheduler::BranchAndBoundScheduler bnb_scheduler;
+   jcdp::scheduler::BranchAndBoundSchedulerGPU bnb_scheduler_gpu;
+
+   inline auto chain(const std::int64_t length) -> BenchChain& {
+      const auto it = std::ranges::find_if(chains, [&](const BenchChain& c) {
+         return static_cast<std::int64_t>(c.chain.length()) == length;
+      });
+      if (it == chains.end()) {
+         throw std::out_of_range("No chain of that length");
+      }
+      return *it;
+   }
+};
+
+using Benchmark = std::function<void(benchmark::State&, BenchContext&)>;
+
+//! Sequence a scheduler schedules "from scratch" in every iteration.
+inline auto unscheduled(jcdp::Sequence sequence) -> jcdp::Sequence {
+   for (jcdp::Operation& op : sequence) {
+      op.thread = 0;
+      op.start_time = 0;
+      op.is_scheduled = false;
+   }
+   return sequence;
+}
+
+auto bench_critical_path(benchmark::State& state, BenchContext& ctx) -> void {
+   const jcdp::Sequence& seq = ctx.chain(state.range(0)).dp_sequences[0];
+   for (auto _ : state) {
+      benchmark::DoNotOptimize(seq.critical_path());
+   }
+   state.SetItemsProcessed(state.iterations() * seq.length());
+}
+
+auto bench_earliest_start(benchmark::State& state, BenchContext& ctx)
+     -> void {
+   const jcdp::Sequence& seq = ctx.chain(state.range(0)).dp_sequences[0];
+   for (auto _ : state) {
+      for (std::size_t i = 0; i < seq.length(); ++i) {
+         benchmark::DoNotOptimize(seq.earliest_start(i));
+      }
+   }
+   state.SetItemsProcessed(state.iterations() * seq.length());
+}
+
+auto bench_is_schedulable(benchmark::State& state, BenchContext& ctx)
+     -> void {
+   // Half of the operations scheduled, so that both outcomes occur
+   jcdp::Sequence seq = unscheduled(ctx.chain(state.range(0)).dp_sequences[0]);
+   for (std::size_t i = 0; i < seq.length() / 2; ++i) {
+      seq[i].is_scheduled = true;
+   }
+   for (auto _ : state) {
+      for (std::size_t i = 0; i < seq.length(); ++i) {
+         benchmark::DoNotOptimize(seq.is_schedulable(i));
+      }
+   }
+   state.SetItemsProcessed(state.iterations() * seq.length());
+}
+
+//! Schedule the DP sequence for the thread count of the benchmark.
+auto bench_scheduler(
+     benchmark::State& state, BenchContext& ctx,
+     jcdp::scheduler::Scheduler& scheduler) -> void {
+   const std::size_t threads = state.range(1);
+   const jcdp::Sequence dp_seq = unscheduled(
+        ctx.chain(state.range(0)).dp_sequences[threads]);
+
+   scheduler.set_timer(ctx.properties.schedule_time());
+   jcdp::Sequence seq = dp_seq;
+   std::size_t makespan = 0;
+   bool finished = true;
+   for (auto _ : state) {
+      seq = dp_seq;
+      makespan = scheduler.schedule(seq, threads);
+      finished &= scheduler.finished_in_time();
+   }
+   state.counters["makespan"] = static_cast<double>(makespan);
+   state.counters["finished"] = finished;
+}
+
+//! Single accumulation, i.e. the latency of an offload without any search.
+auto bench_gpu_offload(benchmark::State& state, BenchContext& ctx) -> void {
+   const jcdp::Jacobian jac = ctx.chains.front().chain.elemental_jacobians[0];
+   jcdp::Sequence seq;
+   seq.push_back(
+        {.action = jcdp::Action::ACCUMULATION,
+         .mode = jcdp::Mode::TANGENT,
+         .j = 0,
+         .k = 0,
+         .i = 0,
+         .fma = jac.fma<jcdp::Mode::TANGENT>()});
+
+   for (auto _ : state) {
+      benchmark::DoNotOptimize(ctx.bnb_scheduler_gpu.schedule(seq, 1));
+   }
+   state.counters["devices"] = omp_get_num_devices();
+}
+
+auto bench_dp(benchmark::State& state, BenchContext& ctx) -> void {
+   const jcdp::JacobianChain& chain = ctx.chain(state.range(0)).chain;
+   std::size_t makespan = 0;
+   for (auto _ : state) {
+      ctx.dp_solver.init(chain);
+      ctx.dp_solver.m_usable_threads = state.range(1);
+      makespan = ctx.dp_solver.solve().makespan();
+   }
+   state.counters["makespan"] = static_cast<double>(makespan);
+}
+
+//! Branch & bound with list scheduling, bounded by the DP makespan.
+auto bench_bnb(benchmark::State& state, BenchContext& ctx) -> void {
+   const std::size_t threads = state.range(1);
+   BenchChain& bc = ctx.chain(state.range(0));
+   const std::size_t dp_makespan = bc.dp_sequences[threads].makespan();
+
+   std::size_t makespan = 0;
+   bool finished = true;
+   std::size_t leafs = 0;
+   for (auto _ : state) {
+      // Every iteration starts cold
+      ctx.bnb_solver.clear_schedule_cache();
+      ctx.bnb_solver.init(bc.chain, &ctx.list_scheduler);
+      ctx.bnb_solver.set_upper_bound(dp_makespan);
+      ctx.bnb_solver.set_sequential_cost(bc.sequential_cost);
+      ctx.bnb_solver.set_guide(bc.dp_sequences[threads]);
+      ctx.bnb_solver.m_usable_threads = threads;
+      makespan = std::min(ctx.bnb_solver.solve().makespan(), dp_makespan);
+      finished &= ctx.bnb_solver.is_complete();
+      leafs = ctx.bnb_solver.statistics().leafs;
+   }
+   state.counters["makespan"] = static_cast<double>(makespan);
+   state.counters["finished"] = finished;
+   state.counters["leafs"] = static_cast<double>(leafs);
+}
+
+//! Register a benchmark per chain length (and thread count).
+auto register_benchmark(
+     BenchContext& ctx, const std::string& name, Benchmark bench,
+     const bool per_threads, const benchmark::TimeUnit unit) -> void {
+   benchmark::internal::Benchmark* b = benchmark::RegisterBenchmark(
+        name.c_str(), [&ctx, bench](benchmark::State& state) {
+           bench(state, ctx);
+        });
+   b->Unit(unit)->UseRealTime();
+
+   if (!per_threads) {
+      b->ArgName("length");
+      for (const BenchChain& bc : ctx.chains) {
+         b->Arg(bc.chain.length());
+      }
+      return;
+   }
+
+   b->ArgNames({"length", "threads"});
+   for (const BenchChain& bc : ctx.chains) {
+      for (const std::size_t t : ctx.properties.threads()) {
+         if (t > 0 && t <= bc.chain.length()) {
+            b->Args(
+                 {static_cast<std::int64_t>(bc.chain.length()),
+                  static_cast<std::int64_t>(t)});
+         }
+      }
+   }
+}
+
+}  // end namespace
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> APPLICATION <<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+int main(int argc, char* argv[]) {
+   // Removes the --benchmark_* flags
+   benchmark::Initialize(&argc, argv);
+
+   jcdp::JacobianChainGenerator jcgen;
+   auto context = std::make_unique<BenchContext>();
+
+   if (argc < 2) {
+      jcgen.print_help(std::cout);
+      context->dp_solver.print_help(std::cout);
+      context->properties.print_help(std::cout);
+      benchmark::PrintDefaultHelp();
+      return -1;
+   }
+
+   const std::filesystem::path config_filename(argv[1]);
+   try {
+      jcgen.parse_config(config_filename, true);
+      jcgen.set_chain_source(jcdp::open_chain_corpus(jcgen.corpus_path()));
+      jcgen.init();
+      context->properties.parse_config(config_filename, true);
+      context->dp_solver.parse_config(config_filename, true);
+      context->bnb_solver.parse_config(config_filename, true);
+      context->bnb_scheduler.parse_config(config_filename, true);
+      context->bnb_scheduler_gpu.parse_config(config_filename, true);
+   } catch (const std::runtime_error& bcfe) {
+      std::println(std::cerr, "{}", bcfe.what());
+      return -1;
+   }
+
+   // First chain of every length, with its DP sequences for all thread
+   // counts (as the upper bounds and inputs of the schedulers)
+   jcdp::JacobianChain skipped;
+   while (!jcgen.empty()) {
+      BenchChain& bc = context->chains.emplace_back();
+      bool more = jcgen.next(bc.chain);
+      while (more) {
+         more = jcgen.next(skipped);
+      }
+      bc.chain.init_subchains();
+
+      context->dp_solver.init(bc.chain);
+      context->dp_solver.m_usable_threads = bc.chain.length();
+      context->dp_solver.solve();
+      bc.sequential_cost = context->dp_solver.sequential_cost();
+      for (std::size_t t = 0; t <= bc.chain.length(); ++t) {
+         bc.dp_sequences.push_back(
+              t == 0 ? context->dp_solver.get_sequence()
+                     : context->dp_solver.get_sequence(t));
+      }
+   }
+   if (context->chains.empty()) {
+      std::println(std::cerr, "No chains to benchmark");
+      return -1;
+   }
+
+   // Same buffers as jcdp_batch
+   context->workspace.reserve(jcgen.max_length(), omp_get_max_threads());
+   context->list_scheduler.set_workspace(&context->workspace);
+   context->bnb_scheduler.set_workspace(&context->workspace);
+   context->dp_solver.reserve(jcgen.max_length());
+   context->bnb_solver.reserve(jcgen.max_length());
+
+   BenchContext& c = *context;
+   const auto ns = benchmark::kNanosecond;
+   const auto us = benchmark::kMicrosecond;
+   const auto ms = benchmark::kMillisecond;
+   register_benchmark(
+        c, "Sequence/critical_path", bench_critical_path, false, ns);
+   register_benchmark(
+        c, "Sequence/earliest_start", bench_earliest_start, false, ns);
+   register_benchmark(
+        c, "Sequence/is_schedulable", bench_is_schedulable, false, ns);
+   register_benchmark(
+        c, "PriorityListScheduler",
+        [](benchmark::State& state, BenchContext& ctx) {
+           bench_scheduler(state, ctx, ctx.list_scheduler);
+        },
+        true, us);
+   register_benchmark(
+        c, "BranchAndBoundScheduler",
+        [](benchmark::State& state, BenchContext& ctx) {
+           bench_scheduler(state, ctx, ctx.bnb_scheduler);
+        },
+        true, us);
+   register_benchmark(
+        c, "BranchAndBoundSchedulerGPU",
+        [](benchmark::State& state, BenchContext& ctx) {
+           bench_scheduler(state, ctx, ctx.bnb_scheduler_gpu);
+        },
+        true, us);
+   benchmark::RegisterBenchmark(
+        "BranchAndBoundSchedulerGPU/offload_latency",
+        [&c](benchmark::State& state) {
+           bench_gpu_offload(state, c);
+        })
+        ->Unit(us)
+        ->UseRealTime();
+   register_benchmark(c, "DynamicProgrammingOptimizer", bench_dp, true, us);
+   register_benchmark(c, "BranchAndBoundOptimizer", bench_bnb, true, ms);
+
+   benchmark::AddCustomContext("config", config_filename.string());
+   benchmark::AddCustomContext(
+        "devices", std::to_string(omp_get_num_devices()));
+   benchmark::RunSpecifiedBenchmarks();
+   benchmark::Shutdown();
+
+   return 0;
+}